@@ -15,6 +15,7 @@
 #include "octotiger/options.hpp"
 #include "octotiger/physcon.hpp"
 #include "octotiger/problem.hpp"
+#include "octotiger/telemetry.hpp"
 #include "octotiger/test_problems/blast.hpp"
 #include "octotiger/test_problems/rotating_star.hpp"
 #include "octotiger/unitiger/physics.hpp"
@@ -153,7 +154,7 @@ void start_octotiger(int argc, char* argv[]) {
                 std::cerr << "Loading from " << opts().restart_filename << " ...\n";
                 load_data_from_silo(opts().restart_filename, root, root_client.get_unmanaged_gid());
                 std::cerr << "Re-grid" << std::endl;
-                ngrids = root->regrid(root_client.get_unmanaged_gid(), ZERO, -1, true, false);
+                ngrids = root->regrid(root_client.get_unmanaged_gid(), ZERO, -1, true, false, true);
                 std::cerr << "Done!" << std::endl;
 
                 set_AB(physcon().A, physcon().B);
@@ -162,27 +163,24 @@ void start_octotiger(int argc, char* argv[]) {
                 std::cerr << "Starting refinement" << std::endl;
                 for (integer l = 0; l < opts().max_level; ++l) {
                     ngrids =
-                        root->regrid(root_client.get_gid(), grid::get_omega(), -1, false, false);
+                        root->regrid(root_client.get_gid(), grid::get_omega(), -1, false, false, true);
                     std::cerr << "---------------Created Level " << int(l + 1)
                               << "---------------\n"
                               << std::endl;
                 }
-                ngrids = root->regrid(root_client.get_gid(), grid::get_omega(), -1, false, false);
+                ngrids = root->regrid(root_client.get_gid(), grid::get_omega(), -1, false, false, true);
                 std::cerr << "---------------Re-gridded Level " << int(opts().max_level)
                           << "---------------\n"
                           << std::endl;
             }
             for (integer l = 0; l < opts().extra_regrid; ++l) {
                 std::cerr << "Starting extra regridding step..." << std::endl;
-                ngrids = root->regrid(root_client.get_gid(), grid::get_omega(), -1, false, false);
+                ngrids = root->regrid(root_client.get_gid(), grid::get_omega(), -1, false, false, true);
                 std::cerr << "Finished extra regridding step..." << std::endl;
             }
 
-            if (opts().gravity && opts().stop_step != 0) {
-                std::cerr << "solving gravity------------" << std::endl;
-                root->solve_gravity(false, false);
-                std::cerr << "...done" << std::endl;
-            }
+            // The regrids above leave the gravity solve to the solver, which solves once for the
+            // final tree before it is needed
             if (opts().problem != AMR_TEST) {
                 std::cerr << "Start execution the solver..." << std::endl;
                 hpx::async(&node_server::execute_solver, root,
@@ -208,13 +206,13 @@ void start_octotiger(int argc, char* argv[]) {
         throw;
     }
     printf("Exiting...\n");
-    FILE* fp = fopen("profile.txt", "wt");
-    profiler_output(fp);
-    fclose(fp);
 }
 
 void register_hpx_functions(void) {
     hpx::register_startup_function(&node_server::register_counters);
-    hpx::register_pre_shutdown_function([]() { options::all_localities.clear(); });
+    hpx::register_pre_shutdown_function([]() {
+        telemetry::flush();
+        options::all_localities.clear();
+    });
 }
 #endif
@@ -6,14 +6,19 @@
 
 #pragma once
 
+#include "octotiger/options.hpp"
+
 #include <cstdlib>
+#include <vector>
 
 // Get called once
 
 void start_octotiger(int argc, char* argv[]);
 void register_hpx_functions();
+void cleanup();
 
 // Get called once per locality
+void initialize(options _opts, std::vector<hpx::id_type> const& localities);
 void init_executors();
 void init_problem();
 
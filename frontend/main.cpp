@@ -12,6 +12,7 @@
 #endif
 
 #include "frontend-helper.hpp"
+#include "octotiger/io/io_pool.hpp"
 
 #include <chrono>
 #include <cstdio>
@@ -131,6 +132,7 @@ int main(int argc, char* argv[]) {
         "hpx.parcel.mpi.zero_copy_optimization!=0"    // Disable the usage of zero copy optimization
                                                       // for MPI...
     };
+    io::configure(p, argc, argv);
     register_hpx_functions();
     hpx::init(argc, argv, p);
 #ifdef OCTOTIGER_HAVE_HIP
@@ -0,0 +1,436 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Kernel micro-benchmarks
+//
+// Runs the compute kernels of Octo-Tiger on a single synthetic sub-grid (the root grid of the
+// selected problem) without building the octree, so their node level performance can be tracked
+// per kernel, backend and INX. All regular octotiger options are accepted (the problem determines
+// the initial data, --hydro/--gravity/--radiation select the kernel groups), plus
+//
+//     --kernel_repetitions=N   timed calls per kernel (default 100)
+//     --kernel_json=FILE       machine readable results (default kernel_benchmarks.json)
+//
+// GFLOP/s are derived from approximate operation counts of the kernel bodies and are meant for
+// comparing backends and sub-grid sizes, not as absolute hardware efficiency.
+
+#include <hpx/config/compiler_specific.hpp>
+#if !defined(HPX_COMPUTE_DEVICE_CODE)
+
+#include <hpx/hpx_init.hpp>
+#include <hpx/include/runtime.hpp>
+#include <hpx/timing.hpp>
+#if HPX_VERSION_FULL > 0x010600
+// Can't find hpx::find_all_localities() in newer HPX versions without this header
+#include <hpx/modules/runtime_distributed.hpp>
+#endif
+#ifdef OCTOTIGER_HAVE_KOKKOS
+#include <hpx/kokkos.hpp>
+#endif
+
+#include "frontend/frontend-helper.hpp"
+
+#include "octotiger/coarse_mask.hpp"
+#include "octotiger/defs.hpp"
+#include "octotiger/geometry.hpp"
+#include "octotiger/grid.hpp"
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/kernel_counters.hpp"
+#include "octotiger/monopole_interactions/monopole_kernel_interface.hpp"
+#include "octotiger/monopole_interactions/util/calculate_stencil.hpp"
+#include "octotiger/multipole_interactions/multipole_kernel_interface.hpp"
+#include "octotiger/multipole_interactions/util/calculate_stencil.hpp"
+#include "octotiger/options.hpp"
+#include "octotiger/physcon.hpp"
+#include "octotiger/problem.hpp"
+#include "octotiger/radiation/rad_grid.hpp"
+#include "octotiger/unitiger/hydro_impl/hydro_boundary_exchange.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Same operation counts as the --hw_counters roofline
+using kernel_counters::amr_flops_per_fine_cell_and_field;
+using kernel_counters::hydro_flops_per_cell_and_field;
+using kernel_counters::monopole_flops_per_interaction;
+using kernel_counters::multipole_flops_per_interaction;
+using kernel_counters::p2m_flops_per_interaction;
+using kernel_counters::rad_explicit_flops_per_cell;
+using kernel_counters::rad_implicit_flops_per_cell;
+
+int repetitions = 100;
+std::string json_file = "kernel_benchmarks.json";
+
+struct kernel_result {
+    std::string kernel;
+    std::string variant;
+    int calls;
+    double seconds;
+    double cells;    // cells processed per call
+    double flops;    // estimated flops per call
+};
+
+std::vector<kernel_result> results;
+
+// Times repetitions calls of kernel after one untimed warm-up call, setup runs before every call
+// and is not timed
+template <class Setup, class Kernel>
+void run_kernel(const std::string& kernel, const std::string& variant, double cells, double flops,
+    Setup&& setup, Kernel&& kernel_func) {
+    setup();
+    kernel_func();
+    double seconds = 0.0;
+    for (int rep = 0; rep < repetitions; rep++) {
+        setup();
+        hpx::chrono::high_resolution_timer timer;
+        kernel_func();
+        seconds += timer.elapsed();
+    }
+    results.push_back(kernel_result{kernel, variant, repetitions, seconds, cells, flops});
+    const double per_call = seconds / repetitions;
+    printf("%-12s %-10s %12.3e s/call %12.3e cells/s %10.3f GFLOP/s\n", kernel.c_str(),
+        variant.c_str(), per_call, cells / per_call, flops / per_call * 1.0e-9);
+}
+
+template <class Kernel>
+void run_kernel(const std::string& kernel, const std::string& variant, double cells, double flops,
+    Kernel&& kernel_func) {
+    run_kernel(kernel, variant, cells, flops, []() {}, kernel_func);
+}
+
+std::vector<std::pair<std::string, interaction_host_kernel_type>> host_variants() {
+    std::vector<std::pair<std::string, interaction_host_kernel_type>> variants;
+    variants.emplace_back("legacy", interaction_host_kernel_type::LEGACY);
+#ifdef OCTOTIGER_HAVE_KOKKOS
+    variants.emplace_back("kokkos", interaction_host_kernel_type::KOKKOS);
+#endif
+    return variants;
+}
+
+std::shared_ptr<grid> make_grid(real dx, std::array<real, NDIM> xmin) {
+    return std::make_shared<grid>(get_problem(), dx, xmin);
+}
+
+void benchmark_hydro(real dx, std::array<real, NDIM> xmin) {
+    auto g = make_grid(dx, xmin);
+    g->store();
+    g->acquire_stage_scratch();
+    const double cells = INX * INX * INX;
+    const double flops = cells * opts().n_fields * hydro_flops_per_cell_and_field;
+    opts().hydro_device_kernel_type = interaction_device_kernel_type::OFF;
+    for (const auto& v : host_variants()) {
+        opts().hydro_host_kernel_type = v.second;
+        run_kernel("hydro", v.first, cells, flops, [&]() { g->compute_fluxes(); });
+    }
+    g->release_stage_scratch();
+    g->release_step_scratch();
+}
+
+// Coarse data of a fine grid that is surrounded by coarser neighbors on all sides, the worst
+// case of the AMR boundary completion. Values are taken from the grid itself.
+real shadow_value(grid& g, int f, int i, int j, int k) {
+    const auto fine = [](integer c) { return std::min(std::max(2 * c - H_BW, integer(0)), H_NX - 1); };
+    return g.get_field(f)[hindex(fine(i), fine(j), fine(k))];
+}
+
+void benchmark_amr(real dx, std::array<real, NDIM> xmin) {
+    auto g = make_grid(dx, xmin);
+    const int nf = opts().n_fields;
+
+    // Inputs of the free function kernels
+    std::vector<std::vector<real>> ushad(nf, std::vector<real>(HS_N3, 0.0));
+    coarse_mask is_coarse(HS_N3);
+    // Inputs of the grid member kernel, one buffer per direction
+    std::vector<std::pair<geo::direction, std::vector<real>>> boundaries;
+    for (auto const& dir : geo::direction::full_set()) {
+        std::array<integer, NDIM> lb, ub;
+        get_boundary_size(lb, ub, dir, OUTER, INX / 2, H_BW);
+        for (int i = lb[0]; i < ub[0]; i++) {
+            for (int j = lb[1]; j < ub[1]; j++) {
+                for (int k = lb[2]; k < ub[2]; k++) {
+                    is_coarse.mark(hSindex(i, j, k));
+                }
+            }
+        }
+        for (int dim = 0; dim < NDIM; dim++) {
+            lb[dim] = std::max(lb[dim] - 1, integer(0));
+            ub[dim] = std::min(ub[dim] + 1, integer(HS_NX));
+        }
+        std::vector<real> data;
+        for (int f = 0; f < nf; f++) {
+            for (int i = lb[0]; i < ub[0]; i++) {
+                for (int j = lb[1]; j < ub[1]; j++) {
+                    for (int k = lb[2]; k < ub[2]; k++) {
+                        const auto v = shadow_value(*g, f, i, j, k);
+                        ushad[f][hSindex(i, j, k)] = v;
+                        data.push_back(v);
+                    }
+                }
+            }
+        }
+        boundaries.emplace_back(dir, std::move(data));
+    }
+    int interior = 0;
+    for (const int iii0 : is_coarse.cells()) {
+        interior += is_interior_shadow_cell(iii0);
+    }
+    const double cells = 8.0 * interior;
+    const double flops = cells * nf * amr_flops_per_fine_cell_and_field;
+
+    for (auto& b : boundaries) {
+        g->set_hydro_amr_boundary(b.second, b.first, false);
+    }
+    run_kernel("amr", "legacy", cells, flops, [&]() { g->complete_hydro_amr_boundary(false); });
+    g->release_amr_scratch();
+
+    field_storage<real> u(nf, H_N3);
+    for (int f = 0; f < nf; f++) {
+        const auto field = g->get_field(f);
+        std::copy(field.begin(), field.end(), u[f].begin());
+    }
+    const auto& X = g->get_X();
+    std::array<double, NDIM> x0;
+    for (int dim = 0; dim < NDIM; dim++) {
+        x0[dim] = X[dim][0];
+    }
+    run_kernel("amr", "optimized", cells, flops, [&]() {
+        complete_hydro_amr_boundary_cpu(dx, false, ushad, is_coarse, x0, u);
+    });
+#if defined __x86_64__ && defined OCTOTIGER_HAVE_VC
+    run_kernel("amr", "vc", cells, flops, [&]() {
+        complete_hydro_amr_boundary_vc(dx, false, ushad, is_coarse, x0, u);
+    });
+#endif
+}
+
+// Multipoles of a refined grid, gathered from its eight children like node_server::compute_fmm
+void gather_child_multipoles(real dx, std::array<real, NDIM> xmin, multipole_pass_type& m_out) {
+    m_out.first.resize(INX * INX * INX);
+    m_out.second.resize(INX * INX * INX);
+    for (auto& ci : geo::octant::full_set()) {
+        std::array<real, NDIM> cmin;
+        for (int dim = 0; dim < NDIM; dim++) {
+            cmin[dim] = xmin[dim] + ci.get_side(dim) * (INX / 2) * dx;
+        }
+        auto child = make_grid(dx / 2, cmin);
+        const auto m_in = child->compute_multipoles(RHO);
+        const integer x0 = ci.get_side(XDIM) * INX / 2;
+        const integer y0 = ci.get_side(YDIM) * INX / 2;
+        const integer z0 = ci.get_side(ZDIM) * INX / 2;
+        for (integer i = 0; i != INX / 2; ++i) {
+            for (integer j = 0; j != INX / 2; ++j) {
+                for (integer k = 0; k != INX / 2; ++k) {
+                    const integer ii = i * INX * INX / 4 + j * INX / 2 + k;
+                    const integer io = (i + x0) * INX * INX + (j + y0) * INX + k + z0;
+                    m_out.first[io] = m_in.first[ii];
+                    m_out.second[io] = m_in.second[ii];
+                }
+            }
+        }
+    }
+}
+
+// All 26 neighbors of g are copies of source (local boundary data, as for neighbors on the same
+// locality)
+std::vector<neighbor_gravity_type> self_neighbors(grid& source, bool is_monopole) {
+    std::vector<neighbor_gravity_type> neighbors;
+    for (auto const& dir : geo::direction::full_set()) {
+        neighbors.push_back(
+            neighbor_gravity_type{source.get_gravity_boundary(dir, true), is_monopole, dir});
+    }
+    return neighbors;
+}
+
+void benchmark_gravity(real dx, std::array<real, NDIM> xmin) {
+    std::array<bool, geo::direction::count()> is_direction_empty;
+    std::fill(is_direction_empty.begin(), is_direction_empty.end(), false);
+    const double cells = INX * INX * INX;
+    opts().multipole_device_kernel_type = interaction_device_kernel_type::OFF;
+    opts().monopole_device_kernel_type = interaction_device_kernel_type::OFF;
+
+    // Refined grid: multipole-multipole interactions
+    auto refined = make_grid(dx, xmin);
+    refined->set_leaf(false);
+    multipole_pass_type m_out;
+    gather_child_multipoles(dx, xmin, m_out);
+    refined->compute_multipoles(RHO, &m_out);
+    {
+        auto neighbors = self_neighbors(*refined, false);
+        std::array<real, NDIM> Xbase = {refined->get_X()[0][hindex(H_BW, H_BW, H_BW)],
+            refined->get_X()[1][hindex(H_BW, H_BW, H_BW)],
+            refined->get_X()[2][hindex(H_BW, H_BW, H_BW)]};
+        const double interactions =
+            octotiger::fmm::multipole_interactions::calculate_stencil().stencil_elements.size();
+        const double flops = cells * interactions * multipole_flops_per_interaction;
+        for (const auto& v : host_variants()) {
+            opts().multipole_host_kernel_type = v.second;
+            run_kernel("multipole", v.first, cells, flops, [&]() {
+                octotiger::fmm::multipole_interactions::multipole_kernel_interface(
+                    refined->get_mon(), refined->get_M(), refined->get_com_ptr(), neighbors, RHO,
+                    refined->get_dx(), is_direction_empty, Xbase, refined, false);
+            });
+        }
+    }
+
+    // Leaf grid: monopole-monopole interactions, and with refined neighbors additionally P2M
+    auto leaf = make_grid(dx, xmin);
+    leaf->compute_multipoles(RHO);
+    const double monopole_interactions =
+        octotiger::fmm::monopole_interactions::calculate_stencil().first.size();
+    {
+        auto neighbors = self_neighbors(*leaf, true);
+        const double flops = cells * monopole_interactions * monopole_flops_per_interaction;
+        for (const auto& v : host_variants()) {
+            opts().monopole_host_kernel_type = v.second;
+            run_kernel("monopole", v.first, cells, flops, [&]() {
+                octotiger::fmm::monopole_interactions::monopole_kernel_interface(leaf->get_mon(),
+                    leaf->get_com_ptr(), neighbors, RHO, leaf->get_dx(), is_direction_empty, leaf,
+                    false);
+            });
+        }
+    }
+    {
+        // The P2M kernel runs as part of the monopole kernel whenever a neighbor is refined
+        auto neighbors = self_neighbors(*refined, false);
+        const double interactions =
+            octotiger::fmm::multipole_interactions::calculate_stencil().stencil_elements.size();
+        const double flops = cells *
+            (monopole_interactions * monopole_flops_per_interaction +
+                interactions * p2m_flops_per_interaction);
+        for (const auto& v : host_variants()) {
+            opts().monopole_host_kernel_type = v.second;
+            run_kernel("p2m", v.first, cells, flops, [&]() {
+                octotiger::fmm::monopole_interactions::monopole_kernel_interface(leaf->get_mon(),
+                    leaf->get_com_ptr(), neighbors, RHO, leaf->get_dx(), is_direction_empty, leaf,
+                    true);
+            });
+        }
+    }
+}
+
+void benchmark_radiation(real dx, std::array<real, NDIM> xmin) {
+    auto g = make_grid(dx, xmin);
+    // The grid constructor already initialized the radiation field and mean molecular weights
+    auto rgrid = g->get_rad_grid();
+    rgrid->set_X(g->get_X());
+    const double cells = INX * INX * INX;
+
+    // Explicit transport, only computes fluxes and leaves the state untouched
+    run_kernel("rad_explicit", "legacy", cells, cells * rad_explicit_flops_per_cell,
+        [&]() { rgrid->compute_flux(grid::get_omega()); });
+
+    rgrid->store();
+
+    // Implicit matter coupling, on a fresh copy of the hydro fields every call
+    const real clight = physcon().c / opts().clight_retard;
+    const real dt = 0.2 * dx / clight;
+    field_storage<real> u(5, H_N3);
+    const field_span<const real> rho = g->get_field(rho_i);
+    run_kernel("rad_implicit", "legacy", cells, cells * rad_implicit_flops_per_cell,
+        [&]() {
+            rgrid->restore();
+            int i = 0;
+            for (const int f : {egas_i, tau_i, sx_i, sy_i, sz_i}) {
+                const auto field = g->get_field(f);
+                std::copy(field.begin(), field.end(), u[i++].begin());
+            }
+        },
+        [&]() { rgrid->rad_imp(u[0], u[1], u[2], u[3], u[4], rho, dt); });
+}
+
+void write_json() {
+    const std::size_t threads = hpx::get_os_thread_count();
+    io::submit([threads]() {
+        FILE* fp = fopen(json_file.c_str(), "wt");
+        if (fp == nullptr) {
+            std::cerr << "ERROR: cannot write " << json_file << std::endl;
+            return;
+        }
+        fprintf(fp, "{\n  \"inx\": %i,\n  \"n_fields\": %i,\n  \"threads\": %zu,\n  \"kernels\": [",
+            int(INX), int(opts().n_fields), threads);
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const auto& r = results[i];
+            const double per_call = r.seconds / r.calls;
+            fprintf(fp,
+                "%s\n    {\"kernel\": \"%s\", \"variant\": \"%s\", \"calls\": %i, \"seconds\": %.9e, "
+                "\"cells_per_second\": %.9e, \"gflops\": %.9e}",
+                i ? "," : "", r.kernel.c_str(), r.variant.c_str(), r.calls, r.seconds,
+                r.cells / per_call, r.flops / per_call * 1.0e-9);
+        }
+        fprintf(fp, "\n  ]\n}\n");
+        fclose(fp);
+    }).get();
+}
+
+// Removes the benchmark options from argv, the remaining ones are regular octotiger options
+void parse_benchmark_options(int& argc, char* argv[]) {
+    int n = 1;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--kernel_repetitions=", 0) == 0) {
+            repetitions = std::atoi(arg.c_str() + std::strlen("--kernel_repetitions="));
+        } else if (arg.rfind("--kernel_json=", 0) == 0) {
+            json_file = arg.substr(std::strlen("--kernel_json="));
+        } else {
+            argv[n++] = argv[i];
+        }
+    }
+    argc = n;
+    if (repetitions < 1) {
+        std::cerr << "ERROR: --kernel_repetitions must be at least 1" << std::endl;
+        abort();
+    }
+}
+
+}    // namespace
+
+int hpx_main(int argc, char* argv[]) {
+#ifdef OCTOTIGER_HAVE_KOKKOS
+    Kokkos::initialize();
+#endif
+    parse_benchmark_options(argc, argv);
+    if (opts().process_options(argc, argv)) {
+        initialize(opts(), hpx::find_all_localities());
+
+        // Root grid of the problem
+        const real dx = TWO * grid::get_scaling_factor() / real(INX);
+        std::array<real, NDIM> xmin;
+        for (int dim = 0; dim < NDIM; dim++) {
+            xmin[dim] = -grid::get_scaling_factor();
+        }
+
+        printf("Kernel benchmarks: INX = %i, %i repetitions\n", int(INX), repetitions);
+        if (opts().hydro) {
+            benchmark_hydro(dx, xmin);
+            benchmark_amr(dx, xmin);
+        }
+        if (opts().gravity) {
+            benchmark_gravity(dx, xmin);
+        }
+        if (opts().radiation) {
+            benchmark_radiation(dx, xmin);
+        }
+        write_json();
+        cleanup();
+    }
+    return hpx::finalize();
+}
+
+int main(int argc, char* argv[]) {
+    hpx::init_params p;
+    p.cfg = {"hpx.commandline.allow_unknown=1"};
+    register_hpx_functions();
+    return hpx::init(argc, argv, p);
+}
+#endif
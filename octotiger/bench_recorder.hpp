@@ -0,0 +1,61 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_BENCH_RECORDER_HPP_
+#define OCTOTIGER_BENCH_RECORDER_HPP_
+
+#include "octotiger/defs.hpp"
+#include "octotiger/profiler.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct node_count_type;
+
+/// Measurements of a --bench run, written to a single JSON file on the root locality.
+///
+/// The time loop is timed per refinement block (refinement_freq() steps in one step() call), so
+/// the benchmark keeps the pipelining of the steps within a block; per step times are block
+/// averages. Blocks starting within the first bench_warmup_steps steps are recorded but not
+/// measured, and the run stops after the block that reaches bench_warmup_steps + bench_steps.
+/// start_measurement() resets the node timings on all localities, so the per phase timings
+/// reported at the end only cover the measured blocks.
+class bench_recorder {
+	struct block_record {
+		integer first_step;
+		integer steps;
+		double seconds;
+		double regrid_seconds;
+		bool measured;
+		std::uint64_t nodes;
+		std::uint64_t leaves;
+		std::uint64_t amr_boundaries;
+	};
+
+	std::vector<block_record> blocks;
+	std::vector<timings_reduction> phases;
+	std::int64_t bytes_sent_start;
+	std::int64_t bytes_sent;
+	bool measuring;
+
+public:
+	bench_recorder();
+
+	/// True once step is past the warm-up
+	static bool is_measured(integer step);
+	/// True once all measured steps have been taken
+	static bool is_done(integer step);
+
+	/// Starts the measurement, later calls do nothing
+	void start_measurement();
+	/// Records steps steps starting at first_step that took seconds in total
+	void record_block(integer first_step, integer steps, double seconds, const node_count_type& ngrids);
+	void record_regrid(double seconds);
+	void stop_measurement();
+	void write(const std::string& filename) const;
+};
+
+#endif /* OCTOTIGER_BENCH_RECORDER_HPP_ */
@@ -0,0 +1,78 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_COARSE_MASK_HPP_
+#define OCTOTIGER_COARSE_MASK_HPP_
+
+#include "octotiger/defs.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/// Set of cells of the AMR shadow grid (HS_NX^3) that are covered by a coarser neighbor.
+///
+/// Membership is kept in a bitset for O(1) lookups and the marked cells are additionally collected
+/// in a compact index list, so the AMR completion only visits the cells that need prolongation and
+/// clear() only touches the cells that were marked.
+class coarse_mask {
+	std::vector<std::uint64_t> bits;
+	std::vector<int> marked;
+
+public:
+	coarse_mask() = default;
+	explicit coarse_mask(int n) {
+		resize(n);
+	}
+
+	void resize(int n) {
+		bits.assign((n + 63) / 64, 0);
+		marked.clear();
+	}
+
+	void mark(int i) {
+		assert(i >= 0 && std::size_t(i >> 6) < bits.size());
+		auto &word = bits[i >> 6];
+		const auto bit = std::uint64_t(1) << (i & 63);
+		if (!(word & bit)) {
+			word |= bit;
+			marked.push_back(i);
+		}
+	}
+
+	bool test(int i) const {
+		return std::size_t(i >> 6) < bits.size() && ((bits[i >> 6] >> (i & 63)) & 1);
+	}
+
+	bool operator[](int i) const {
+		return test(i);
+	}
+
+	/// The marked cells in the order they were marked
+	const std::vector<int>& cells() const {
+		return marked;
+	}
+
+	bool none() const {
+		return marked.empty();
+	}
+
+	void clear() {
+		for (const auto i : marked) {
+			bits[i >> 6] = 0;
+		}
+		marked.clear();
+	}
+};
+
+/// True for shadow grid cells that are not on the outermost layer, the only ones that can be prolonged
+inline bool is_interior_shadow_cell(int iii0) {
+	const int i0 = iii0 / HS_DNX;
+	const int j0 = (iii0 / HS_DNY) % HS_NX;
+	const int k0 = iii0 % HS_NX;
+	return i0 > 0 && i0 < HS_NX - 1 && j0 > 0 && j0 < HS_NX - 1 && k0 > 0 && k0 < HS_NX - 1;
+}
+
+#endif /* OCTOTIGER_COARSE_MASK_HPP_ */
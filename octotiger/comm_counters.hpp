@@ -0,0 +1,63 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_COMM_COUNTERS_HPP_
+#define OCTOTIGER_COMM_COUNTERS_HPP_
+
+#include "octotiger/interaction_types.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// Message and payload byte counts of the node_server boundary exchange actions, split into
+/// sends to components on the same locality and sends to other localities.
+///
+/// The counts are taken on the sending side, in node_client. Payload bytes are the bytes of the
+/// data vectors only, local sends do not serialize them but are counted the same way so that both
+/// columns can be compared directly. The counters are exposed as
+/// /octotiger/comm/<action>/{local,remote}/{messages,bytes}.
+namespace comm_counters {
+
+enum action_type {
+	hydro_boundary,
+	hydro_amr_boundary,
+	hydro_children,
+	hydro_flux_correct,
+	flux_check,
+	gravity_boundary,
+	gravity_multipoles,
+	gravity_expansions,
+	rad_boundary,
+	rad_amr_boundary,
+	rad_children,
+	rad_flux_correct,
+	action_count
+};
+
+const char* name(action_type action);
+
+void record(action_type action, bool is_local, std::size_t bytes);
+
+/// Installs the counter types, called from node_server::register_counters
+void register_counters();
+
+template <class T>
+std::size_t payload_bytes(const std::vector<T>& v) {
+	return v.size() * sizeof(T);
+}
+
+template <class T, class U>
+std::size_t payload_bytes(const std::pair<std::vector<T>, std::vector<U>>& v) {
+	return payload_bytes(v.first) + payload_bytes(v.second);
+}
+
+inline std::size_t payload_bytes(const gravity_boundary_type& v) {
+	return (v.M ? payload_bytes(*v.M) : 0) + (v.m ? payload_bytes(*v.m) : 0) + (v.x ? payload_bytes(*v.x) : 0);
+}
+
+}
+
+#endif /* OCTOTIGER_COMM_COUNTERS_HPP_ */
@@ -0,0 +1,48 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_CONSERVED_SUMS_HPP_
+#define OCTOTIGER_CONSERVED_SUMS_HPP_
+
+#include "octotiger/defs.hpp"
+#include "octotiger/real.hpp"
+
+#include <hpx/include/serialization.hpp>
+
+#include <array>
+#include <vector>
+
+/// Conserved quantities of the leaves at the start of a step (--conserved_sums_freq).
+///
+/// Every leaf sums its interior cells before it advances and sends the result to the root
+/// locality, the step itself does not wait. A sample is complete once the leaves reporting to it
+/// cover the whole domain. Unlike node_server::diagnostics() this needs neither ghost cells nor a
+/// tree reduction.
+struct conserved_sums_t {
+	/// Volume integral plus outflow of every field (egas includes the potential energy as in sums.dat)
+	std::vector<real> fields;
+	/// Angular momentum sums as in sums.dat
+	std::array<real, NDIM> lsum = { { 0.0, 0.0, 0.0 } };
+	/// Fraction of the domain covered
+	real volume = 0.0;
+
+	conserved_sums_t& operator+=(const conserved_sums_t& other);
+
+	template<class Arc>
+	void serialize(Arc& arc, unsigned) {
+		arc & fields;
+		arc & lsum;
+		arc & volume;
+	}
+};
+
+/// Called by a leaf on refinement level level at the start of step
+void conserved_sums_submit(integer step, real time, integer level, conserved_sums_t sums);
+
+/// Root locality: writes the complete samples to conserved.dat and prints their drift against the
+/// first sample. Incomplete samples are kept for the next call unless final is set.
+void conserved_sums_drain(bool final);
+
+#endif /* OCTOTIGER_CONSERVED_SUMS_HPP_ */
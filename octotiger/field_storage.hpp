@@ -0,0 +1,219 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_FIELD_STORAGE_HPP_
+#define OCTOTIGER_FIELD_STORAGE_HPP_
+
+#include <boost/align/aligned_allocator.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/// Non-owning view of a single field, indexable like the std::vector it replaces
+template<class T>
+class field_span {
+	T *ptr;
+	std::size_t n;
+public:
+	field_span(T *p, std::size_t size) :
+			ptr(p), n(size) {
+	}
+	operator field_span<const T>() const {
+		return field_span<const T>(ptr, n);
+	}
+	T& operator[](std::size_t i) const {
+		assert(i < n);
+		return ptr[i];
+	}
+	T* data() const {
+		return ptr;
+	}
+	T* begin() const {
+		return ptr;
+	}
+	T* end() const {
+		return ptr + n;
+	}
+	std::size_t size() const {
+		return n;
+	}
+};
+
+template<class T>
+class field_storage;
+
+/// Non-owning view of all fields of a field_storage (or of any buffer with the same layout).
+/// Kernels and halo packing take this instead of the owner, f-th field at data() + f * stride().
+template<class T>
+class field_view {
+	T *ptr;
+	std::size_t nf;
+	std::size_t n;
+	std::size_t stride_;
+public:
+	field_view(T *p, std::size_t n_fields, std::size_t size, std::size_t stride) :
+			ptr(p), nf(n_fields), n(size), stride_(stride) {
+	}
+	field_view(field_storage<std::remove_const_t<T>> &storage) :
+			field_view(storage.data(), storage.size(), storage.field_size(), storage.stride()) {
+	}
+	template<class U = T, class = std::enable_if_t<std::is_const<U>::value>>
+	field_view(const field_storage<std::remove_const_t<T>> &storage) :
+			field_view(storage.data(), storage.size(), storage.field_size(), storage.stride()) {
+	}
+	operator field_view<const T>() const {
+		return field_view<const T>(ptr, nf, n, stride_);
+	}
+	field_span<T> operator[](std::size_t f) const {
+		assert(f < nf);
+		return field_span<T>(ptr + f * stride_, n);
+	}
+	T* data() const {
+		return ptr;
+	}
+	std::size_t size() const {
+		return nf;
+	}
+	std::size_t field_size() const {
+		return n;
+	}
+	std::size_t stride() const {
+		return stride_;
+	}
+	/// True if the fields follow each other without padding, so the view is one dense block
+	bool dense() const {
+		return stride_ == n;
+	}
+};
+
+/// Copies the first n_fields fields of src to dest, whose fields are dest_stride apart. A single
+/// copy if both strides agree, one copy per field otherwise.
+template<class T>
+void copy_fields(field_view<const T> src, std::size_t n_fields, std::remove_const_t<T> *dest, std::size_t dest_stride) {
+	assert(n_fields <= src.size());
+	if (src.stride() == dest_stride) {
+		if (n_fields > 0) {
+			std::copy(src.data(), src.data() + (n_fields - 1) * dest_stride + src.field_size(), dest);
+		}
+	} else {
+		for (std::size_t f = 0; f < n_fields; f++) {
+			std::copy(src[f].begin(), src[f].end(), dest + f * dest_stride);
+		}
+	}
+}
+
+/// Contiguous structure of arrays storage for n_fields fields of equal size in a single aligned
+/// allocation. The field stride is padded to a multiple of the alignment so kernels can use
+/// aligned loads on every field and move whole grids with a single (strided) copy.
+template<class T>
+class field_storage {
+public:
+	static constexpr std::size_t alignment = 64;
+
+private:
+	static constexpr std::size_t pad = alignment / sizeof(T) > 0 ? alignment / sizeof(T) : 1;
+	std::size_t nf;
+	std::size_t n;
+	std::size_t stride_;
+	std::vector<T, boost::alignment::aligned_allocator<T, alignment>> buffer;
+
+public:
+	field_storage() :
+			nf(0), n(0), stride_(0) {
+	}
+	field_storage(std::size_t n_fields, std::size_t size, const T &init = T()) :
+			field_storage() {
+		resize(n_fields, size, init);
+	}
+	field_storage(const field_storage&) = default;
+	field_storage& operator=(const field_storage&) = default;
+	field_storage(field_storage &&other) noexcept :
+			nf(other.nf), n(other.n), stride_(other.stride_), buffer(std::move(other.buffer)) {
+		other.nf = other.n = other.stride_ = 0;
+	}
+	field_storage& operator=(field_storage &&other) noexcept {
+		nf = other.nf;
+		n = other.n;
+		stride_ = other.stride_;
+		buffer = std::move(other.buffer);
+		other.nf = other.n = other.stride_ = 0;
+		return *this;
+	}
+
+	/// Copies the fields of a view, the allocation is kept if the shape does not change
+	field_storage& operator=(field_view<const T> other) {
+		if (nf != other.size() || n != other.field_size()) {
+			resize(other.size(), other.field_size());
+		}
+		copy_fields(other, nf, buffer.data(), stride_);
+		return *this;
+	}
+
+	void resize(std::size_t n_fields, std::size_t size, const T &init = T()) {
+		nf = n_fields;
+		n = size;
+		stride_ = (size + pad - 1) / pad * pad;
+		buffer.assign(nf * stride_, init);
+	}
+	void clear() {
+		nf = n = stride_ = 0;
+		buffer.clear();
+		buffer.shrink_to_fit();
+	}
+	void fill(const T &value) {
+		std::fill(buffer.begin(), buffer.end(), value);
+	}
+
+	/// Number of fields (mirrors size() of the former vector of fields)
+	std::size_t size() const {
+		return nf;
+	}
+	bool empty() const {
+		return nf == 0;
+	}
+	std::size_t field_size() const {
+		return n;
+	}
+	std::size_t stride() const {
+		return stride_;
+	}
+
+	T* data() {
+		return buffer.data();
+	}
+	const T* data() const {
+		return buffer.data();
+	}
+	field_view<T> view() {
+		return field_view<T>(*this);
+	}
+	field_view<const T> view() const {
+		return field_view<const T>(*this);
+	}
+
+	field_span<T> operator[](std::size_t f) {
+		assert(f < nf);
+		return field_span<T>(buffer.data() + f * stride_, n);
+	}
+	field_span<const T> operator[](std::size_t f) const {
+		assert(f < nf);
+		return field_span<const T>(buffer.data() + f * stride_, n);
+	}
+};
+
+/// Owning container with the shape of a field container, for temporaries derived from it
+template<class S>
+struct owning_fields {
+	using type = S;
+};
+template<class T>
+struct owning_fields<field_view<T>> {
+	using type = field_storage<std::remove_const_t<T>>;
+};
+
+#endif /* OCTOTIGER_FIELD_STORAGE_HPP_ */
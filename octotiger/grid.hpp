@@ -8,10 +8,13 @@
 
 #define SILO_UNITS
 
+#include "octotiger/coarse_mask.hpp"
 #include "octotiger/config.hpp"
 #include "octotiger/config/export_definitions.hpp"
+#include "octotiger/conserved_sums.hpp"
 #include "octotiger/defs.hpp"
 #include "octotiger/diagnostics.hpp"
+#include "octotiger/field_storage.hpp"
 #include "octotiger/geometry.hpp"
 #include "octotiger/interaction_types.hpp"
 #include "octotiger/problem.hpp"
@@ -28,6 +31,7 @@
 #include <hpx/serialization/serialize.hpp>
 #include <hpx/serialization/traits/is_bitwise_serializable.hpp>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -35,6 +39,8 @@
 //#include "octotiger/unitiger/hydro.hpp"
 
 class struct_eos;
+template<class T>
+class scratch_pool;
 
 class analytic_t {
 public:
@@ -121,13 +127,13 @@ private:
 	hydro_computer<NDIM,INX,physics<NDIM>> hydro;
 	std::shared_ptr<rad_grid> rad_grid_ptr;
 	std::vector<roche_type> roche_lobe;
-	std::vector<int> is_coarse;
-	std::vector<int> has_coarse;
+	coarse_mask is_coarse;
+	coarse_mask has_coarse;
 	std::vector<std::vector<real>> Ushad;
-	std::vector<std::vector<safe_real>> U;
-	std::vector<std::vector<safe_real>> U0;
-	std::vector<std::vector<safe_real>> dUdt;
-	std::vector<hydro_state_t<std::vector<safe_real>>> F;
+	field_storage<safe_real> U;
+	field_storage<safe_real> U0;
+	field_storage<safe_real> dUdt;
+	std::vector<field_storage<safe_real>> F;
 	std::vector<std::vector<safe_real>> X;
 #if defined(__AVX2__) && defined(OCTOTIGER_LEGACY_VC)
 	std::vector<v4sd> G;
@@ -142,6 +148,11 @@ private:
 #ifdef OCTOTIGER_HAVE_GRAV_PAR
 	std::unique_ptr<hpx::lcos::local::spinlock> L_mtx;
 #endif
+	// Persistent arrays of grids destroyed on this locality (derefined or migrated away), reused by
+	// allocate() instead of sizing new ones. Trimmed after every regrid, see trim_storage_pool.
+	struct persistent_storage;
+	static scratch_pool<persistent_storage> storage_pool;
+	void release_storage();
 
 //    std::shared_ptr<std::atomic<integer>> Muse_counter;
 	bool is_root;
@@ -150,6 +161,10 @@ private:
 	std::array<real, NDIM> xmin;
 	std::vector<real> U_out;
 	std::vector<real> U_out0;
+	// Copies of U, G and U_out taken by snapshot_diagnostics, diagnostics() reads these while the next step runs
+	field_storage<safe_real> diag_U;
+	decltype(G) diag_G;
+	std::vector<real> diag_U_out;
 	std::vector<std::shared_ptr<std::vector<space_vector>>> com_ptr;
 	static bool xpoint_eq(const xpoint& a, const xpoint& b);
 	void compute_boundary_interactions_multipole_multipole(gsolve_type type, const std::vector<boundary_interaction_type>&,
@@ -212,24 +227,23 @@ public:
 	}
 	static std::vector<std::pair<std::string,std::string>> get_scalar_expressions();
 	static std::vector<std::pair<std::string,std::string>> get_vector_expressions();
-	std::vector<safe_real>& get_field(integer f) {
+	field_span<safe_real> get_field(integer f) {
 		return U[f];
 	}
-	const std::vector<safe_real>& get_field(integer f) const {
+	field_span<const safe_real> get_field(integer f) const {
 		return U[f];
 	}
-	void set_field(std::vector<safe_real>&& data, integer f) {
-		U[f] = std::move(data);
-	}
 	void set_field(const std::vector<safe_real>& data, integer f) {
-		U[f] = data;
+		std::copy(data.begin(), data.end(), U[f].begin());
 	}
 	analytic_t compute_analytic(real);
 	void compute_boundary_interactions(gsolve_type, const geo::direction&, bool is_monopole, const gravity_boundary_type&);
 	static void set_scaling_factor(real f) {
 		scaling_factor = f;
 	}
+	void snapshot_diagnostics();
 	diagnostics_t diagnostics(const diagnostics_t& diags);
+	conserved_sums_t conserved_sums() const;
 	static real get_scaling_factor() {
 		return scaling_factor;
 	}
@@ -266,6 +280,8 @@ public:
 	bool is_in_star(const std::pair<space_vector, space_vector>& axis, const std::pair<real, real>& l1, integer frac,
 			integer index, real rho_cut) const;
 	static void set_omega(real, bool bcast = true);
+	/// Keeps the arrays of at most keep destroyed grids per locality for the next regrid
+	static void trim_storage_pool(std::size_t keep, bool bcast = true);
 	static OCTOTIGER_EXPORT real& get_omega();
 	line_of_centers_t line_of_centers(const std::pair<space_vector, space_vector>& line);
 	void set_coordinates();
@@ -322,6 +338,7 @@ public:
 	grid(real dx, std::array<real, NDIM>);
 	grid();
 	~grid() {
+		release_storage();
 	}
 	grid(const grid&) = delete;
 	grid(grid&&) = default;
@@ -338,6 +355,13 @@ public:
 
 	const std::vector<boundary_interaction_type>& get_ilist_n_bnd(const geo::direction &dir);
 	void allocate();
+	void acquire_step_scratch();
+	void release_step_scratch();
+	void acquire_stage_scratch();
+	void release_stage_scratch();
+	bool has_amr_scratch() const;
+	void acquire_amr_scratch();
+	void release_amr_scratch();
 	void store();
 	void restore();
 	timestep_t compute_fluxes();
@@ -390,21 +414,21 @@ void grid::load(Archive& arc, const unsigned) {
 	arc >> dx;
 	arc >> xmin;
 	allocate();
-	arc >> U;
+	std::vector<safe_real> interior;
+	for (std::size_t f = 0; f != U.size(); ++f) {
+		const auto u = U[f];
+		arc >> interior;
+		for (integer i = 0; i != INX; ++i) {
+			for (integer j = 0; j != INX; ++j) {
+				std::copy(interior.begin() + (i * INX + j) * INX, interior.begin() + (i * INX + j + 1) * INX,
+						u.begin() + hindex(i + H_BW, j + H_BW, H_BW));
+			}
+		}
+	}
 	if (rad_grid_ptr != nullptr) {
 		arc >> *rad_grid_ptr;
 		rad_grid_ptr->set_dx(dx);
 	}
-	for (integer i = 0; i != INX * INX * INX; ++i) {
-#if defined(HPX_HAVE_DATAPAR)
-		arc >> G[i];
-#else
-		arc >> G[i][0];
-		arc >> G[i][1];
-		arc >> G[i][2];
-		arc >> G[i][3];
-#endif
-	}
 	arc >> U_out;
 }
 
@@ -415,20 +439,22 @@ void grid::save(Archive& arc, const unsigned) const {
 	arc << is_root;
 	arc << dx;
 	arc << xmin;
-	arc << U;
+	// Only the conserved variables of the interior cells. The ghost zones are filled by the next
+	// boundary exchange and the gravitational field by the solve at the end of the regrid.
+	std::vector<safe_real> interior(INX * INX * INX);
+	for (std::size_t f = 0; f != U.size(); ++f) {
+		const auto u = U[f];
+		for (integer i = 0; i != INX; ++i) {
+			for (integer j = 0; j != INX; ++j) {
+				std::copy(u.begin() + hindex(i + H_BW, j + H_BW, H_BW), u.begin() + hindex(i + H_BW, j + H_BW, H_BW + INX),
+						interior.begin() + (i * INX + j) * INX);
+			}
+		}
+		arc << interior;
+	}
 	if (rad_grid_ptr != nullptr) {
 		arc << *rad_grid_ptr;
 	}
-	for (integer i = 0; i != INX * INX * INX; ++i) {
-#if defined(HPX_HAVE_DATAPAR)
-		arc << G[i];
-#else
-		arc << G[i][0];
-		arc << G[i][1];
-		arc << G[i][2];
-		arc << G[i][3];
-#endif
-	}
 	arc << U_out;
 }
 
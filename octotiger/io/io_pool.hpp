@@ -0,0 +1,48 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_IO_POOL_HPP_
+#define OCTOTIGER_IO_POOL_HPP_
+
+#include <hpx/hpx_init_params.hpp>
+#include <hpx/include/parallel_executors.hpp>
+#include <hpx/include/run_as.hpp>
+#include <hpx/include/threads.hpp>
+
+#include <utility>
+
+// All file I/O of Octo-Tiger (SILO checkpoints, the *.dat logs, traces and reports) runs on a
+// dedicated HPX thread pool. The pool gets its own PUs from the resource partitioner, so blocking
+// system calls never stall the worker threads that run the solver. By default (--io_threads=-1)
+// the pool has one core on nodes with at least 8 cores; with --io_threads=0, or on smaller nodes,
+// every I/O task runs on a separate OS thread.
+namespace io {
+
+/// Name of the HPX thread pool doing the file I/O
+constexpr const char* pool_name = "io";
+
+/// Reads opts().io_threads from the command line and the configuration file and registers the
+/// resource partitioner callback creating the I/O pool. Called by main() before hpx::init.
+void configure(hpx::init_params& params, int argc, char* argv[]);
+
+/// The I/O pool of this locality, nullptr if there is none (--io_threads=0, not enough cores or a
+/// driver that does not call configure)
+hpx::threads::thread_pool_base* pool();
+
+/// Runs f(ts...) on the I/O pool. Without an I/O pool it falls back to a separate OS thread.
+/// Arguments and captures held by reference must outlive the returned future.
+template<class F, class ... Ts>
+auto submit(F&& f, Ts&&... ts) -> decltype(hpx::threads::run_as_os_thread(std::forward<F>(f), std::forward<Ts>(ts)...)) {
+	if (auto* p = pool()) {
+		// SILO and stdio need more stack than a default HPX thread provides
+		hpx::execution::parallel_executor exec(p, hpx::threads::thread_priority::default_, hpx::threads::thread_stacksize::huge);
+		return hpx::async(exec, std::forward<F>(f), std::forward<Ts>(ts)...);
+	}
+	return hpx::threads::run_as_os_thread(std::forward<F>(f), std::forward<Ts>(ts)...);
+}
+
+}
+
+#endif /* OCTOTIGER_IO_POOL_HPP_ */
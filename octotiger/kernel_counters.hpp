@@ -0,0 +1,104 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_KERNEL_COUNTERS_HPP_
+#define OCTOTIGER_KERNEL_COUNTERS_HPP_
+
+#include "octotiger/interaction_types.hpp"
+#include "octotiger/options.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Roofline instrumentation of the host compute kernels (--hw_counters).
+//
+// Every host call of the hydro, AMR completion, multipole, monopole and radiation kernels is
+// attributed to its kernel and variant (the host kernel type). Wall time, the analytic FLOP and
+// byte counts of the call and, on Linux, the perf_event_open counters of the calling OS thread
+// (cycles, instructions, last level cache misses and an optional raw FP event) are summed up per
+// OS thread. report() places every kernel variant on the roofline of the host CPU.
+namespace kernel_counters {
+
+enum kernel_type {
+	hydro, amr_completion, multipole, monopole, radiation, kernel_count
+};
+
+constexpr int max_variants = 4;
+
+enum amr_variant {
+	amr_legacy, amr_optimized, amr_vc, amr_cuda
+};
+
+enum radiation_variant {
+	radiation_explicit, radiation_implicit
+};
+
+// Approximate floating point operations of the kernel bodies
+constexpr double hydro_flops_per_cell_and_field = 1200.0;    // reconstruction of 27 directions + face fluxes
+constexpr double amr_flops_per_fine_cell_and_field = 40.0;   // 6 limited slopes + prolongation
+constexpr double multipole_flops_per_interaction = 455.0;    // M2L incl. angular momentum correction
+constexpr double monopole_flops_per_interaction = 12.0;      // P2P
+constexpr double p2m_flops_per_interaction = 160.0;          // P2M
+constexpr double rad_explicit_flops_per_cell = 600.0;
+constexpr double rad_implicit_flops_per_cell = 250.0;
+
+/// Analytic work of one kernel call. Bytes are the compulsory traffic: every input read once and
+/// every output written once.
+struct kernel_cost {
+	double flops;
+	double bytes;
+};
+
+kernel_cost hydro_cost();
+kernel_cost amr_cost(std::size_t coarse_cells);
+kernel_cost multipole_cost();
+kernel_cost monopole_cost(bool contains_multipole_neighbor);
+kernel_cost radiation_cost(radiation_variant v);
+
+/// Variant of the AMR completion that runs on this build for kernel type t
+amr_variant amr_kernel_variant(amr_boundary_type t);
+
+inline bool enabled() {
+	return opts().hw_counters;
+}
+
+struct thread_table;
+
+class scope {
+	thread_table* table_;
+	kernel_cost cost_;
+	std::uint64_t start_;
+	std::uint64_t hw_start_[4];
+	int kernel_;
+	int variant_;
+	bool active_;
+	void begin();
+	void end();
+public:
+	/// cost is only evaluated when the counters are enabled
+	template<class Cost>
+	scope(kernel_type k, int variant, Cost&& cost) :
+			kernel_(k), variant_(variant), active_(enabled()) {
+		if (active_) {
+			cost_ = cost();
+			begin();
+		}
+	}
+	~scope() {
+		if (active_) {
+			end();
+		}
+	}
+	scope(const scope&) = delete;
+	scope& operator=(const scope&) = delete;
+};
+
+/// Sums the counters of all localities, prints the roofline table and writes it to json_file
+void report(const std::string& json_file);
+
+}
+
+#endif /* OCTOTIGER_KERNEL_COUNTERS_HPP_ */
@@ -0,0 +1,47 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_LOAD_BALANCE_HPP_
+#define OCTOTIGER_LOAD_BALANCE_HPP_
+
+#include "octotiger/defs.hpp"
+
+#include <hpx/include/serialization.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/// Work of one locality during the last block of refinement_freq() steps
+struct locality_load {
+	std::uint64_t nodes = 0;
+	std::uint64_t leaves = 0;
+	std::uint64_t amr_boundaries = 0;
+	/// Busy time summed over the worker threads, -1 if HPX has no such counter
+	double busy = -1.0;
+	/// Fraction of the time the worker threads were idle, -1 if HPX has no such counter
+	double idle_rate = -1.0;
+
+	template<class Arc>
+	void serialize(Arc& arc, unsigned) {
+		arc & nodes;
+		arc & leaves;
+		arc & amr_boundaries;
+		arc & busy;
+		arc & idle_rate;
+	}
+};
+
+/// Load of this locality since the previous call (the HPX thread counters are reset)
+locality_load load_collect();
+
+/// Collects the load of all localities, prints it, appends it to loadbalance.dat in the data
+/// directory and, with --load_balance_weighted, updates the partition used by the next regrid.
+/// Called on the root locality after every block of refinement_freq() steps.
+void load_balance_report(integer step);
+
+/// Locality of the node at position a (of total) along the space filling curve
+integer load_balance_locality(integer a, integer total);
+
+#endif /* OCTOTIGER_LOAD_BALANCE_HPP_ */
@@ -87,6 +87,7 @@ public:
     void send_rad_flux_correct(std::vector<real>&&, const geo::face& face,
         const geo::octant& ci) const;
     future<diagnostics_t> diagnostics(const diagnostics_t&) const;
+    future<void> snapshot_diagnostics() const;
     future<analytic_t> compare_analytic() const;
     //	hpx::future<void> set_parent(hpx::id_type);
     node_client();
@@ -124,6 +125,7 @@ public:
     future<void> velocity_inc(const space_vector&) const;
     future<void> energy_adj() const;
     future<void> check_for_refinement(real omega, real) const;
+    future<node_count_type> pending_refinement(bool clear) const;
     future<void> enforce_bc() const;
     future<void> force_nodes_to_exist(std::vector<node_location>&& loc) const;
     void report_timing() const;
@@ -10,6 +10,7 @@
 #include "octotiger/defs.hpp"
 #include "octotiger/node_server.hpp"
 
+#include <cstddef>
 #include <unordered_map>
 
 namespace node_registry {
@@ -23,7 +24,34 @@ struct hash {
 
 using node_ptr = node_client;
 using table_type = std::unordered_map<node_location,node_ptr,hash>;
-using iterator_type = table_type::iterator;
+
+// The table is split into shards with a lock each. The shard is selected by a multiplicative hash
+// of the Morton id of the location, which spreads the nodes of a subtree (registering at the same
+// time during a regrid) over all shards.
+constexpr std::size_t shard_bits = 6;
+constexpr std::size_t shard_count = std::size_t(1) << shard_bits;
+
+// Walks all shards, the registry must not change during an iteration
+class iterator_type {
+	std::size_t shard_;
+	table_type::iterator i_;
+	void skip_empty();
+public:
+	iterator_type(std::size_t shard, table_type::iterator i);
+	table_type::value_type& operator*() const {
+		return *i_;
+	}
+	table_type::value_type* operator->() const {
+		return &*i_;
+	}
+	iterator_type& operator++();
+	bool operator==(const iterator_type& other) const {
+		return shard_ == other.shard_ && (shard_ == shard_count || i_ == other.i_);
+	}
+	bool operator!=(const iterator_type& other) const {
+		return !(*this == other);
+	}
+};
 
 void add(const node_location&, node_ptr);
 
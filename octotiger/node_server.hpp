@@ -38,14 +38,21 @@ struct node_count_type {
 	std::uint64_t total;
 	std::uint64_t leaf;
 	std::uint64_t amr_bnd;
+	// Changes of the last regrid_gather
+	std::uint64_t refined;
+	std::uint64_t derefined;
+	std::uint64_t held;
 	template<class A>
 	void serialize(A& arc, unsigned) {
 		arc & total;
 		arc & leaf;
 		arc & amr_bnd;
+		arc & refined;
+		arc & derefined;
+		arc & held;
 	}
 	node_count_type() {
-		total = leaf = amr_bnd = std::uint64_t(0);
+		total = leaf = amr_bnd = refined = derefined = held = std::uint64_t(0);
 	}
 };
 
@@ -60,6 +67,17 @@ private:
 	};
 	integer position;
 	std::atomic<integer> refinement_flag;
+	// Step at which the node was refined, and whether only the hysteresis kept it refined in the
+	// last check_for_refinement
+	integer refined_at_step;
+	bool refinement_held;
+	// All ghost zones were exchanged at the end of the last step (--refinement_reuse_bounds), reset
+	// by every regrid so that all nodes agree on it
+	bool hydro_bounds_current;
+	// Root only: a regrid left the gravity solve to solve_deferred_gravity(), which applies the
+	// energy correction if all regrids since the last solve asked for it
+	bool gravity_stale;
+	bool gravity_stale_energy;
 	node_location my_location;
 	integer step_num;
 	std::size_t rcycle;
@@ -137,19 +155,25 @@ private:
 	static node_count_type cumulative_node_count;
 	static bool static_initialized;
 	static std::atomic<integer> static_initializing;
-	void initialize(real, real);
+	void initialize(real, real, bool new_grid = true);
 	void send_hydro_amr_boundaries(bool energy_only=false);
 	void collect_hydro_boundaries(bool energy_only=false);
 	static void static_initialize();
 	void clear_family();
 	hpx::future<void> exchange_flux_corrections();
 
-	hpx::future<void> nonrefined_step();
-	void refined_step();
+	/// Both return false if the step was rejected and has to be repeated (--timestep_lagged)
+	hpx::future<bool> nonrefined_step(bool lagged);
+	bool refined_step(bool lagged);
+	bool full_bounds_at_step_end() const;
+	real stop_time_timestep() const;
+	real lagged_timestep() const;
+	bool accept_lagged_timestep(const hpx::shared_future<timestep_t>& reduced_fut, real lag_dt);
 
 	diagnostics_t root_diagnostics(const diagnostics_t& diags);
 	diagnostics_t child_diagnostics(const diagnostics_t& diags);
 	diagnostics_t local_diagnostics(const diagnostics_t& diags);
+	diagnostics_t snapshot_diagnostics_sums(real time, const space_vector& grid_com);
 	hpx::future<real> local_step(integer steps);
 
 public:
@@ -165,6 +189,8 @@ public:
 	bool refined() const {
 		return is_refined;
 	}
+	/// Number of coarse-fine faces of the children that this node fills (see amr_flags)
+	integer amr_boundary_count() const;
 	void set_time( real t, real r ) {
 		current_time = t;
 		rotational_time = r;
@@ -186,7 +212,7 @@ public:
 
 	/*TODO move radiation to*/
 	node_server(const node_location&, integer, bool, real, real, const std::array<integer, NCHILD>&, grid,
-			const std::vector<hpx::id_type>&, std::size_t, std::size_t, std::size_t, integer position);
+			const std::vector<hpx::id_type>&, std::size_t, std::size_t, std::size_t, integer position, integer refined_at);
 
 	void report_timing();/**/
 	HPX_DEFINE_COMPONENT_ACTION(node_server, report_timing, report_timing_action);
@@ -227,13 +253,21 @@ public:
 
 	void update();
 
-	node_count_type regrid(const hpx::id_type& root_gid, real omega, real new_floor, bool rb, bool grav_energy_comp=true);
+	/// refinement_checked: the caller already ran check_for_refinement on the tree, see refinement_changed
+	node_count_type regrid(const hpx::id_type& root_gid, real omega, real new_floor, bool rb, bool grav_energy_comp=true,
+			bool defer_gravity=false, bool refinement_checked=false);
+
+	/// Root: runs check_for_refinement and returns whether it flagged a node to be refined or derefined.
+	/// If not, the flags are cleared and the regrid can be skipped, the tree would stay the same.
+	bool refinement_changed(real omega, real new_floor);
 
 	void compute_fmm(gsolve_type gs, bool energy_account, bool allocate_only = false);
 
 	void solve_gravity(bool ene, bool skip_solve);/**/
 	HPX_DEFINE_COMPONENT_ACTION(node_server, solve_gravity, solve_gravity_action);
 
+	void solve_deferred_gravity();
+
 	void execute_solver(bool scf, node_count_type);
 
 	void set_grid(const std::vector<real>&, std::vector<real>&&);/**/
@@ -268,8 +302,14 @@ public:
 	diagnostics_t diagnostics(const diagnostics_t&);/**/
 	HPX_DEFINE_COMPONENT_ACTION(node_server, diagnostics, diagnostics_action);
 
+	void snapshot_diagnostics();/**/
+	HPX_DEFINE_COMPONENT_ACTION(node_server, snapshot_diagnostics, snapshot_diagnostics_action);
+
 	diagnostics_t diagnostics();
 
+	/// Snapshots the tree and returns the diagnostics of the snapshot, which may overlap the next step
+	hpx::future<diagnostics_t> diagnostics_async();
+
 	void set_aunt(const hpx::id_type&, const geo::face& face);/**/
 	HPX_DEFINE_COMPONENT_DIRECT_ACTION(node_server, set_aunt, set_aunt_action);
 
@@ -279,6 +319,9 @@ public:
 	void check_for_refinement(real omega, real new_floor);/**/
 	HPX_DEFINE_COMPONENT_ACTION(node_server, check_for_refinement, check_for_refinement_action);
 
+	node_count_type pending_refinement(bool clear);/**/
+	HPX_DEFINE_COMPONENT_ACTION(node_server, pending_refinement, pending_refinement_action);
+
 	void enforce_bc();/**/
 	HPX_DEFINE_COMPONENT_ACTION(node_server, enforce_bc, enforce_bc_action);
 
@@ -362,6 +405,7 @@ HPX_REGISTER_ACTION_DECLARATION(node_server::scf_update_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::set_grid_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::force_nodes_to_exist_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::check_for_refinement_action);
+HPX_REGISTER_ACTION_DECLARATION(node_server::pending_refinement_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::enforce_bc_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::set_aunt_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::set_child_aunt_action);
@@ -383,6 +427,7 @@ HPX_REGISTER_ACTION_DECLARATION(node_server::get_child_client_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::form_tree_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::get_ptr_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::diagnostics_action);
+HPX_REGISTER_ACTION_DECLARATION(node_server::snapshot_diagnostics_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::timestep_driver_ascend_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::scf_params_action);
 HPX_REGISTER_ACTION_DECLARATION(node_server::send_rad_boundary_action);
@@ -52,12 +52,23 @@ public:
 	bool correct_am_hydro;
 	bool rotating_star_amr;
 	bool idle_rates;
+	bool load_balance_report;
+	bool load_balance_weighted;
+	bool hw_counters;
+	bool telemetry_binary;
+	bool timestep_all_reduce;
+	bool timestep_lagged;
+	bool refinement_reuse_bounds;
+	bool refinement_adaptive;
 	bool ipr_test;
+	bool ipr_table;
+	bool ipr_table_polish;
 
 	integer scf_output_frequency;
 	integer silo_num_groups;
 	integer amrbnd_order;
 	integer extra_regrid;
+	integer refinement_min_lifetime;
 	integer accretor_refine;
 	integer donor_refine;
 	integer min_level;
@@ -69,8 +80,23 @@ public:
 	integer silo_offset_z;
 	integer future_wait_time;
 	integer ipr_nr_maxiter;
+	integer bench_warmup_steps;
+	integer bench_steps;
+	integer trace_start_step;
+	integer trace_steps;
+	integer trace_buffer_size;
+	integer hw_fp_event;
+	integer io_threads;
+	integer telemetry_buffer_rows;
+	integer diagnostics_freq;
+	integer conserved_sums_freq;
 
 	real dt_max;
+	real load_imbalance_threshold;
+	real roofline_peak_gflops;
+	real roofline_peak_gbs;
+	real telemetry_flush_interval;
+	real timestep_lag_safety;
 	real eblast0;
 	real rotating_star_x;
 	real dual_energy_sw2;
@@ -83,6 +109,7 @@ public:
 	real omega;
 	real output_dt;
 	real refinement_floor;
+	real derefinement_floor_ratio;
 	real stop_time;
 	real theta;
 	real xscale;
@@ -138,6 +165,9 @@ public:
 	std::string data_dir;
 	std::string output_filename;
 	std::string restart_filename;
+	std::string bench_json;
+	std::string trace_file;
+	std::string hw_counters_json;
 	integer n_species;
 	integer n_fields;
 
@@ -168,6 +198,8 @@ public:
 		arc & ipr_nr_tol;
 		arc & ipr_test;
 		arc & ipr_nr_maxiter;
+		arc & ipr_table;
+		arc & ipr_table_polish;
 		arc & sod_rhol;
 		arc & sod_rhor;
 		arc & sod_pl;
@@ -222,6 +254,27 @@ public:
 		arc & hydro;
 		arc & gravity;
 		arc & bench;
+		arc & bench_warmup_steps;
+		arc & bench_steps;
+		arc & bench_json;
+		arc & trace_start_step;
+		arc & trace_steps;
+		arc & trace_buffer_size;
+		arc & trace_file;
+		arc & hw_counters;
+		arc & hw_counters_json;
+		arc & hw_fp_event;
+		arc & io_threads;
+		arc & telemetry_flush_interval;
+		arc & telemetry_buffer_rows;
+		arc & telemetry_binary;
+		arc & diagnostics_freq;
+		arc & conserved_sums_freq;
+		arc & timestep_all_reduce;
+		arc & timestep_lagged;
+		arc & timestep_lag_safety;
+		arc & roofline_peak_gflops;
+		arc & roofline_peak_gbs;
 		arc & radiation;
 		arc & multipole_host_kernel_type;
 		arc & multipole_device_kernel_type;
@@ -234,6 +287,10 @@ public:
 		arc & driving_rate;
 		arc & driving_time;
 		arc & refinement_floor;
+		arc & derefinement_floor_ratio;
+		arc & refinement_min_lifetime;
+		arc & refinement_reuse_bounds;
+		arc & refinement_adaptive;
 		arc & ngrids;
 		arc & v1309;
 		arc & clight_retard;
@@ -257,6 +314,9 @@ public:
 		arc & extra_regrid;
 		arc & accretor_refine;
 		arc & idle_rates;
+		arc & load_balance_report;
+		arc & load_balance_weighted;
+		arc & load_imbalance_threshold;
 		int tmp = problem;
 		arc & tmp;
 		problem = static_cast<problem_type>(tmp);
@@ -67,6 +67,22 @@ OCTOTIGER_EXPORT bool refine_blast(integer level, integer max_level, real x,
     real y, real z, std::vector<real> const& U,
     std::array<std::vector<real>, NDIM> const& dudx);
 
+/// Density floor of the refinement criteria. It is refinement_floor, lowered by
+/// derefinement_floor_ratio while a refinement_hysteresis_scope is active on the calling thread
+/// (a refined node checking whether it stays refined).
+OCTOTIGER_EXPORT real refinement_density_floor();
+
+/// grid::refine_me runs the criteria of one node to completion without suspending, so a flag of the
+/// OS thread cannot leak into the check of another node
+class OCTOTIGER_EXPORT refinement_hysteresis_scope {
+	bool previous_;
+public:
+	explicit refinement_hysteresis_scope(bool active);
+	~refinement_hysteresis_scope();
+	refinement_hysteresis_scope(const refinement_hysteresis_scope&) = delete;
+	refinement_hysteresis_scope& operator=(const refinement_hysteresis_scope&) = delete;
+};
+
 OCTOTIGER_EXPORT void set_refine_test(const refine_test_type&);
 OCTOTIGER_EXPORT refine_test_type get_refine_test();
 OCTOTIGER_EXPORT void set_problem(const init_func_type&);
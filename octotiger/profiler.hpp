@@ -12,14 +12,50 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <string>
+#include <vector>
 
-struct profiler_register {
-	profiler_register(const char*, int);
+// Region profiler behind the PROFILE() macro, compiled in with OCTOTIGER_WITH_PROFILER (default ON).
+//
+// Every PROFILE() site registers itself once (function local static) and receives a small integer
+// id. Entering and leaving a region only reads the clock and updates the fixed-size counter table of
+// the calling OS thread, there are no locks or allocations on that path. The tables of all threads
+// (and of all localities) are summed up when the profile is reported.
+//
+// Exclusive times are derived by passing the inclusive time of a region up to the enclosing region
+// of the same HPX thread. The innermost open scope is kept in the user data word of the HPX thread,
+// not in OS thread local state, so a region that suspends and resumes on another OS thread still
+// finds its parent. Regions of child tasks (async, dataflow) start a chain of their own.
+constexpr int profiler_max_regions = 256;
+
+/// Registers a region and returns its id, all regions beyond profiler_max_regions share id 0
+int profiler_register(const char* func, int line);
+
+struct profiler_entry {
+	std::string name;
+	double inclusive;
+	double exclusive;
+	std::uint64_t calls;
+
+	template<class Arc>
+	void serialize(Arc& arc, unsigned) {
+		arc & name;
+		arc & inclusive;
+		arc & exclusive;
+		arc & calls;
+	}
 };
-void profiler_enter(const char* func, int line);
-void profiler_exit();
+
+/// Counters of this locality, summed over all threads
+std::vector<profiler_entry> profiler_collect();
+/// Writes the table of this locality to fp and stdout
 void profiler_output(FILE* fp);
+/// Sums the counters of all localities, prints the table and writes it to txt_file and json_file
+void profiler_report(const std::string& txt_file, const std::string& json_file);
 
 struct timings
 {
@@ -31,9 +67,45 @@ struct timings
         time_find_localities = 4,
 		  time_fmm = 5,
 		  time_io = 6,
-	     time_last = 7
+        // Per node phases
+        time_reconstruct_flux = 7,
+        time_flux_correction = 8,
+        time_halo_pack = 9,
+        time_halo_unpack = 10,
+        time_amr_completion = 11,
+        time_sources_next_u = 12,
+        time_m2m = 13,
+        time_multipole_kernel = 14,
+        time_monopole_kernel = 15,
+        time_l2l = 16,
+        time_radiation_substeps = 17,
+        time_diagnostics = 18,
+        time_silo_stages = 19,
+        time_form_tree = 20,
+        time_migration = 21,
+	     time_last = 22
     };
 
+    static const char* name(std::size_t t)
+    {
+        static const char* const names[timer::time_last] = { "total", "computation", "regrid",
+            "compare_analytic", "find_localities", "fmm", "io", "reconstruct_flux",
+            "flux_correction", "halo_pack", "halo_unpack", "amr_completion", "sources_next_u",
+            "m2m", "multipole_kernel", "monopole_kernel", "l2l", "radiation_substeps",
+            "diagnostics", "silo_stages", "form_tree", "migration" };
+        return names[t];
+    }
+
+    /// Adds dt to timer t. Continuations of one node run concurrently (for instance the halo
+    /// exchange of different directions), so the timers are updated with a compare and swap.
+    static void add_time(std::atomic<double>& t, double dt)
+    {
+        double old = t.load(std::memory_order_relaxed);
+        while (!t.compare_exchange_weak(old, old + dt, std::memory_order_relaxed))
+        {
+        }
+    }
+
     struct scope
     {
         scope(timings &t, timer tt)
@@ -43,32 +115,60 @@ struct timings
 
         ~scope()
         {
-            time_ += timer_.elapsed();
+            add_time(time_, timer_.elapsed());
         }
 
         hpx::chrono::high_resolution_timer timer_;
-        double& time_;
+        std::atomic<double>& time_;
     };
 
     timings()
     {
         for (std::size_t i = 0; i < timer::time_last; ++i)
         {
-            times_[i] = 0.0;
+            times_[i].store(0.0, std::memory_order_relaxed);
         }
     }
 
+    timings(timings const& other)
+    {
+        *this = other;
+    }
+
+    timings& operator=(timings const& other)
+    {
+        for (std::size_t i = 0; i < timer::time_last; ++i)
+        {
+            times_[i].store(other.get(i), std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    double get(std::size_t t) const
+    {
+        return times_[t].load(std::memory_order_relaxed);
+    }
+
     template <typename Archive>
     void serialize(Archive& ar, unsigned)
     {
-        ar & times_;
+        std::array<double, timer::time_last> t;
+        for (std::size_t i = 0; i < timer::time_last; ++i)
+        {
+            t[i] = get(i);
+        }
+        ar & t;
+        for (std::size_t i = 0; i < timer::time_last; ++i)
+        {
+            times_[i].store(t[i], std::memory_order_relaxed);
+        }
     }
 
     void min(timings const& other)
     {
         for (std::size_t i = 0; i < timer::time_last; ++i)
         {
-            times_[i] = (std::min)(times_[i], other.times_[i]);
+            times_[i].store((std::min)(get(i), other.get(i)), std::memory_order_relaxed);
         }
     }
 
@@ -76,43 +176,105 @@ struct timings
     {
         for (std::size_t i = 0; i < timer::time_last; ++i)
         {
-            times_[i] = (std::max)(times_[i], other.times_[i]);
+            times_[i].store((std::max)(get(i), other.get(i)), std::memory_order_relaxed);
+        }
+    }
+
+    void add(timings const& other)
+    {
+        for (std::size_t i = 0; i < timer::time_last; ++i)
+        {
+            add_time(times_[i], other.get(i));
         }
     }
 
     void report(std::string const& name)
     {
-        if (times_[time_total] > 0.0) {
-            const auto tinv = 1.0/ times_[time_total];
-            const auto tcr = times_[time_computation] + times_[time_regrid];
+        const double total = get(time_total);
+        if (total > 0.0) {
+            const auto tinv = 1.0/ total;
+            const double computation = get(time_computation);
+            const double regrid = get(time_regrid);
+            const auto tcr = computation + regrid;
             std::cout << name << ":" << std::endl;
-            std::cout << "   Total: "             << times_[time_total] << std::endl;
-            std::cout << "   Computation: "       << times_[time_computation] << " (" <<  100*times_[time_computation] * tinv << " %)" << std::endl;
-            std::cout << "   Regrid: "            << times_[time_regrid]  << " (" <<  100*times_[time_regrid] * tinv << " %)" << std::endl;
+            std::cout << "   Total: "             << total << std::endl;
+            std::cout << "   Computation: "       << computation << " (" <<  100*computation * tinv << " %)" << std::endl;
+            std::cout << "   Regrid: "            << regrid  << " (" <<  100*regrid * tinv << " %)" << std::endl;
             std::cout << "   Computation + Regrid: "       << tcr << " (" <<  100*tcr * tinv << " %)" << std::endl;
         } else {
             std::cout << "   Warning! Total time is 0! " << std::endl;
         }
     }
 
-    std::array<double, timer::time_last> times_;
+    std::array<std::atomic<double>, timer::time_last> times_;
 };
 
-struct profiler_scope {
-	profiler_scope(const char* function, int line) {
-		profiler_enter(function, line);
-	}
-	~profiler_scope() {
-		profiler_exit();
-	}
+/// Per phase min/max/mean of the node timings of one locality
+struct timings_reduction
+{
+    timings min_;
+    timings max_;
+    timings sum_;
+    std::uint64_t nodes_ = 0;
+
+    void add_node(timings const& t)
+    {
+        if (nodes_ == 0)
+        {
+            min_ = t;
+            max_ = t;
+        }
+        else
+        {
+            min_.min(t);
+            max_.max(t);
+        }
+        sum_.add(t);
+        ++nodes_;
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, unsigned)
+    {
+        ar & min_;
+        ar & max_;
+        ar & sum_;
+        ar & nodes_;
+    }
 };
+
+/// Reduces the timings of all nodes on this locality
+timings_reduction timings_collect();
+/// Zeroes the timings of all nodes on this locality
+void timings_reset();
+/// timings_collect() of every locality, in the order of options::all_localities
+std::vector<timings_reduction> timings_collect_all();
+/// timings_reset() on every locality
+void timings_reset_all();
+/// Prints the per phase node timings of every locality
+void timings_report_phases();
+
+class profiler_scope {
+	profiler_scope* parent_;
+	std::uint64_t start_;
+	std::uint64_t child_;
+	int id_;
+public:
+	profiler_scope(int id);
+	~profiler_scope();
+	profiler_scope(const profiler_scope&) = delete;
+	profiler_scope& operator=(const profiler_scope&) = delete;
+};
+
+#if !defined(OCTOTIGER_HAVE_PROFILER) && !defined(PROFILE_OFF)
 #define PROFILE_OFF
+#endif
 
 #ifdef PROFILE_OFF
 #define PROFILE()
 #else
-#define PROFILE() static profiler_register prof_reg(__FUNCTION__, __LINE__); \
-	             profiler_scope __profile_object__(__FUNCTION__, __LINE__)
+#define PROFILE() static const int prof_id_ = profiler_register(__FUNCTION__, __LINE__); \
+	             profiler_scope __profile_object__(prof_id_)
 #endif
 
 
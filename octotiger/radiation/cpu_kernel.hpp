@@ -7,6 +7,7 @@
 #define RADIATION_CPU_KERNEL_HPP_
 
 #include "octotiger/defs.hpp"
+#include "octotiger/field_storage.hpp"
 #include "octotiger/options.hpp"
 #include "octotiger/physcon.hpp"
 #include "octotiger/radiation/implicit.hpp"
@@ -147,12 +148,12 @@ namespace octotiger { namespace radiation {
 
     template <integer er_i, integer fx_i, integer fy_i, integer fz_i>
     void radiation_cpu_kernel(integer const d,
-        std::vector<real> const& rho,
-        std::vector<real>& sx,
-        std::vector<real>& sy,
-        std::vector<real>& sz,
-        std::vector<real>& egas,
-        std::vector<real>& tau,
+        field_span<const real> rho,
+        field_span<real> sx,
+        field_span<real> sy,
+        field_span<real> sz,
+        field_span<real> egas,
+        field_span<real> tau,
         real const fgamma,
         std::vector<std::vector<real>>& U,
         std::vector<real> const& mmw,
@@ -6,11 +6,12 @@
 #pragma once
 
 #include "octotiger/defs.hpp"
+#include "octotiger/field_storage.hpp"
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/radiation/cpu_kernel.hpp"
 #include "octotiger/radiation/cuda_kernel.hpp"
 #include "octotiger/real.hpp"
 
-#include <hpx/include/run_as.hpp>
 
 #include <array>
 #include <vector>
@@ -145,12 +146,12 @@ namespace octotiger { namespace radiation {
 
     template <integer er_i, integer fx_i, integer fy_i, integer fz_i>
     void radiation_kernel(integer const d,
-        std::vector<real> const& rho,
-        std::vector<real>& sx,
-        std::vector<real>& sy,
-        std::vector<real>& sz,
-        std::vector<real>& egas,
-        std::vector<real>& tau,
+        field_span<const real> rho,
+        field_span<real> sx,
+        field_span<real> sy,
+        field_span<real> sz,
+        field_span<real> egas,
+        field_span<real> tau,
         real const fgamma,
         std::vector<std::vector<real>>& U,
         std::vector<real> const& mmw,
@@ -163,7 +164,7 @@ namespace octotiger { namespace radiation {
         static std::atomic_size_t next_index(0);
         std::size_t index = next_index++;
 
-        hpx::threads::run_as_os_thread([&]() {
+        io::submit([&]() {
             dumper::save_case_args(index, opts().eos, opts().problem,
                 opts().dual_energy_sw1, opts().dual_energy_sw2, physcon().A,
                 physcon().B, physcon().c, fgamma, dt, clightinv, er_i, fx_i,
@@ -176,7 +177,7 @@ namespace octotiger { namespace radiation {
             tau, fgamma, U, mmw, X_spc, Z_spc, dt, clightinv);
 
 #if defined(OCTOTIGER_DUMP_RADIATION_CASES)
-        hpx::threads::run_as_os_thread([&]() {
+        io::submit([&]() {
             dumper::save_case_outs(index, sx, sy, sz, egas, tau, U);
         }).get();
 #endif
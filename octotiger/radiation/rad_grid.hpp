@@ -8,6 +8,7 @@
 
 #include "octotiger/unitiger/safe_real.hpp"
 #include "octotiger/defs.hpp"
+#include "octotiger/field_storage.hpp"
 #include "octotiger/geometry.hpp"
 #include "octotiger/physcon.hpp"
 #include "octotiger/real.hpp"
@@ -64,18 +65,18 @@ public:
 		arc & dx;
 		arc & U;
 	}
-	void compute_mmw(const std::vector<std::vector<safe_real>>& U);
+	void compute_mmw(field_view<const safe_real> U);
 	void change_units(real m, real l, real t, real k);
 	real rad_imp_comoving(real& E, real& e, real rho, real mmw, real X, real Z, real dt);
 	void sanity_check();
 	void compute_flux(real);
-	void initialize_erad(const std::vector<safe_real> rho, const std::vector<safe_real> tau);
+	void initialize_erad(field_span<const safe_real> rho, field_span<const safe_real> tau);
 	void set_dx(real dx);
 	//void compute_fEdd();
 	void compute_fluxes();
 	void advance(real dt, real beta);
-	void rad_imp(std::vector<real>& egas, std::vector<real>& tau, std::vector<real>& sx, std::vector<real>& sy, std::vector<real>& sz,
-			const std::vector<real>& rho, real dt);
+	void rad_imp(field_span<real> egas, field_span<real> tau, field_span<real> sx, field_span<real> sy, field_span<real> sz,
+			field_span<const real> rho, real dt);
 	std::vector<real> get_restrict() const;
 	std::vector<real> get_prolong(const std::array<integer, NDIM>& lb, const std::array<integer, NDIM>& ub);
 	void set_prolong(const std::vector<real>&);
@@ -0,0 +1,100 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_SCRATCH_POOL_HPP_
+#define OCTOTIGER_SCRATCH_POOL_HPP_
+
+#include <hpx/include/runtime.hpp>
+#include <hpx/include/threads.hpp>
+#include <hpx/synchronization/once.hpp>
+#include <hpx/synchronization/spinlock.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Pool of reusable scratch objects (typically bundles of std::vectors) with one free list per
+// worker thread.
+//
+// Objects are taken from the free list of the calling worker and returned to the free list of
+// whichever worker releases them; HPX threads may migrate between borrowing and returning, so
+// every list has its own lock and acquire() falls back to the other workers' lists before handing
+// out a new (default constructed) object. The number of cached objects is therefore bounded by
+// the largest number of objects that were borrowed at the same time, or by trim().
+//
+// Objects released outside of an HPX thread (for instance by static destructors after the
+// runtime stopped) are destroyed instead of being cached.
+template<class T>
+class scratch_pool {
+	struct alignas(64) free_list {
+		hpx::lcos::local::spinlock mtx;
+		std::vector<T> objects;
+	};
+	std::unique_ptr<free_list[]> lists;
+	std::size_t list_count;
+	hpx::lcos::local::once_flag init_flag;
+
+	void init() {
+		hpx::lcos::local::call_once(init_flag, [this]() {
+			list_count = std::max(std::size_t(hpx::get_os_thread_count()), std::size_t(1));
+			lists.reset(new free_list[list_count]);
+		});
+	}
+
+	std::size_t this_list() const {
+		const auto worker = hpx::get_worker_thread_num();
+		return worker < list_count ? worker : 0;
+	}
+
+public:
+	scratch_pool() :
+			list_count(0) {
+	}
+	scratch_pool(const scratch_pool&) = delete;
+	scratch_pool& operator=(const scratch_pool&) = delete;
+
+	/// Returns a previously released object if there is one, a default constructed one otherwise
+	T acquire() {
+		init();
+		const auto home = this_list();
+		for (std::size_t n = 0; n != list_count; ++n) {
+			auto &list = lists[(home + n) % list_count];
+			std::lock_guard<hpx::lcos::local::spinlock> lock(list.mtx);
+			if (!list.objects.empty()) {
+				T object = std::move(list.objects.back());
+				list.objects.pop_back();
+				return object;
+			}
+		}
+		return T();
+	}
+
+	void release(T &&object) {
+		if (hpx::threads::get_self_ptr() == nullptr) {
+			return;
+		}
+		init();
+		auto &list = lists[this_list()];
+		std::lock_guard<hpx::lcos::local::spinlock> lock(list.mtx);
+		list.objects.push_back(std::move(object));
+	}
+
+	/// Destroys cached objects until at most keep are left
+	void trim(std::size_t keep) {
+		init();
+		for (std::size_t n = 0; n != list_count; ++n) {
+			auto &list = lists[n];
+			std::lock_guard<hpx::lcos::local::spinlock> lock(list.mtx);
+			const auto k = std::min(list.objects.size(), keep);
+			list.objects.erase(list.objects.begin() + k, list.objects.end());
+			keep -= k;
+		}
+	}
+};
+
+#endif /* OCTOTIGER_SCRATCH_POOL_HPP_ */
@@ -0,0 +1,34 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_TELEMETRY_HPP_
+#define OCTOTIGER_TELEMETRY_HPP_
+
+#include <vector>
+
+// Buffered per step output of the root locality (step.dat, binary.dat, sums.dat and conserved.dat).
+//
+// Rows are kept in memory per file and handed to the I/O pool in blocks, every
+// telemetry_flush_interval seconds, when telemetry_buffer_rows rows are pending, before every
+// checkpoint and at shutdown. Blocks of one file are written in order. With --telemetry_binary
+// every block is also appended to <file>.bin in a columnar format:
+//
+//   file:  "OCTOTLM1" block*
+//   block: uint64 rows, uint64 columns, double[columns][rows] (column major)
+namespace telemetry {
+
+enum stream_type {
+	step_stream, binary_stream, sums_stream, conserved_stream, stream_count
+};
+
+/// Appends one row to the stream. Text columns keep the formats of the former direct writes.
+void record(stream_type s, std::vector<double> row);
+
+/// Writes all pending rows and waits until they are on disk
+void flush();
+
+}
+
+#endif /* OCTOTIGER_TELEMETRY_HPP_ */
@@ -0,0 +1,36 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_TIMESTEP_REDUCE_HPP_
+#define OCTOTIGER_TIMESTEP_REDUCE_HPP_
+
+#include "octotiger/unitiger/hydro.hpp"
+
+#include <hpx/include/lcos.hpp>
+
+// Global timestep without walking the octree (--timestep_all_reduce).
+//
+// Every node of a locality contributes its timestep once per step (refined nodes contribute
+// "no limit"). When all nodes registered on the locality have done so, the locality minimum
+// enters a single HPX all_reduce among the localities that own nodes, and the result is handed
+// to the local nodes through a shared future instead of per-node actions.
+namespace timestep_reduce {
+
+/// Root locality, before a block of steps (the tree must not change until it is done): sets up
+/// the communicator of the localities that own nodes if that set has changed
+void prepare();
+
+/// Contribution of a local node to the reduction of its current step. The future becomes ready
+/// with the smallest timestep of the whole mesh.
+hpx::shared_future<timestep_t> contribute(const timestep_t& dt);
+
+/// Timestep predicted for the next step (--timestep_lagged): the result of the last reduction on
+/// this locality times timestep_lag_safety, zero if there has been none yet. Every node of the
+/// mesh gets the same value as long as it is read before the node contributes to its step.
+real lagged_dt();
+
+}
+
+#endif /* OCTOTIGER_TIMESTEP_REDUCE_HPP_ */
@@ -0,0 +1,100 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_TRACER_HPP_
+#define OCTOTIGER_TRACER_HPP_
+
+#include "octotiger/node_location.hpp"
+
+#include <hpx/include/serialization.hpp>
+#include <hpx/include/util.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Task tracer for the annotated regions of the node pipeline (--trace_start_step).
+//
+// While tracing is enabled every traced_function() records begin/end time, worker thread and
+// node of each invocation into a ring buffer of the calling OS thread. The buffers of all
+// localities are written as a Chrome trace-event file (chrome://tracing, Perfetto) when the
+// window of traced steps ends. With tracing disabled a region costs one relaxed atomic load.
+
+struct trace_event {
+	std::string name;
+	std::uint64_t begin;	// ns, system clock
+	std::uint64_t end;
+	std::uint32_t worker;
+	node_location::node_id node;
+
+	template<class Arc>
+	void serialize(Arc& arc, unsigned) {
+		arc & name;
+		arc & begin;
+		arc & end;
+		arc & worker;
+		arc & node;
+	}
+};
+
+extern std::atomic<bool> tracer_active;
+
+/// Clears the buffers of this locality and starts (or stops) recording
+void tracer_enable(bool on);
+/// Events of this locality, oldest first
+std::vector<trace_event> tracer_collect();
+/// tracer_enable() on every locality
+void tracer_enable_all(bool on);
+/// Stops recording on all localities and writes their events to filename
+void tracer_write_all(const std::string& filename);
+
+class trace_scope {
+	const char* name_;
+	node_location::node_id node_;
+	std::uint64_t begin_;
+	std::uint32_t worker_;
+	bool active_;
+	void begin();
+	void end();
+public:
+	trace_scope(const char* name, node_location::node_id node) :
+			name_(name), node_(node), active_(tracer_active.load(std::memory_order_relaxed)) {
+		if (active_) {
+			begin();
+		}
+	}
+	~trace_scope() {
+		if (active_) {
+			end();
+		}
+	}
+	trace_scope(const trace_scope&) = delete;
+	trace_scope& operator=(const trace_scope&) = delete;
+};
+
+template <typename F>
+struct traced_invoker {
+	F f;
+	const char* name;
+	node_location::node_id node;
+
+	template <typename ... Ts>
+	decltype(auto) operator()(Ts&& ... args) {
+		trace_scope ts(name, node);
+		return f(std::forward<Ts>(args)...);
+	}
+};
+
+/// hpx::util::annotated_function() that is also recorded by the tracer, for the node at loc
+template <typename F>
+auto traced_function(F&& f, const char* name, const node_location& loc) {
+	return hpx::util::annotated_function(
+			traced_invoker<std::decay_t<F>> { std::forward<F>(f), name, loc.to_id() }, name);
+}
+
+#endif /* OCTOTIGER_TRACER_HPP_ */
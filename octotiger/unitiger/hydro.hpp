@@ -19,6 +19,7 @@ using std::async;
 using std::launch;
 #endif
 
+#include "octotiger/field_storage.hpp"
 #include "octotiger/unitiger/cell_geometry.hpp"
 #include "octotiger/unitiger/util.hpp"
 
@@ -53,13 +54,16 @@ using flux_type = std::vector<std::vector<std::vector<safe_real>>>;
 template<int NDIM>
 using recon_type =std::vector<std::vector<std::vector<safe_real>>>;
 
+// reconstruct, flux and the physics they call also take any other container indexed as
+// U[field][cell], e.g. the field_view of a grid
 using state_type = std::vector<std::vector<safe_real>>;
 }
 
 template<int NDIM, int INX, class PHYSICS>
 struct hydro_computer: public cell_geometry<NDIM, INX> {
 
-	void reconstruct_ppm(std::vector<std::vector<safe_real>> &q, const std::vector<safe_real> &u, bool smooth, bool disc_detect,
+	template<class field_t>
+	void reconstruct_ppm(std::vector<std::vector<safe_real>> &q, const field_t &u, bool smooth, bool disc_detect,
 			const std::vector<std::vector<double>> &disc);
 
 	using geo = cell_geometry<NDIM,INX>;
@@ -68,12 +72,14 @@ struct hydro_computer: public cell_geometry<NDIM, INX> {
 		OUTFLOW, PERIODIC
 	};
 
-	const hydro::recon_type<NDIM>& reconstruct(const hydro::state_type &U, const hydro::x_type&, safe_real);
+	template<class state_t>
+	const hydro::recon_type<NDIM>& reconstruct(const state_t &U, const hydro::x_type&, safe_real);
 //#ifdef OCTOTIGER_WITH_CUDA
 	const hydro::recon_type<NDIM>& reconstruct_cuda(hydro::state_type &U, const hydro::x_type&, safe_real);
 //#endif
 
-	timestep_t flux(const hydro::state_type &U, const hydro::recon_type<NDIM> &Q, hydro::flux_type &F, hydro::x_type &X, safe_real omega);
+	template<class state_t>
+	timestep_t flux(const state_t &U, const hydro::recon_type<NDIM> &Q, hydro::flux_type &F, hydro::x_type &X, safe_real omega);
 	timestep_t flux_experimental(const hydro::recon_type<NDIM> &Q, hydro::flux_type &F, hydro::x_type &X, safe_real omega);
 
 	void post_process(hydro::state_type &U, const hydro::state_type &X, safe_real dx);
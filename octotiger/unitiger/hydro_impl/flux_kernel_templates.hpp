@@ -9,6 +9,8 @@
 #include "octotiger/cuda_util/cuda_global_def.hpp"
 #include "octotiger/hydro_defs.hpp"
 #include "octotiger/common_kernel/kokkos_simd.hpp"
+#include "octotiger/unitiger/ipr_eos_table.hpp"
+#include "octotiger/unitiger/hydro_impl/wd_eos_kernel_templates.hpp"
 
 #if defined(__clang__)
 constexpr int faces[3][9] = {{12, 0, 3, 6, 9, 15, 18, 21, 24}, {10, 0, 1, 2, 9, 11, 18, 19, 20},
@@ -54,6 +56,83 @@ CUDA_GLOBAL_METHOD inline int flip_dim(const int d, const int flip_dim) {
     return k;
 }
 
+/// Vectorized ideal gas plus radiation eos using the tabulated temperature inversion
+/** Computes pressure and sound speed for the reconstructed (conserved) state q, see
+ * physics<NDIM>::to_prim for the scalar version. The table lookup is a per-lane gather, everything
+ * else (Hermite interpolation, Newton polish, adiabatic index) runs on the full simd width.
+ */
+template <typename simd_t>
+CUDA_GLOBAL_METHOD inline void cell_ipr_eos_simd(const ipr_eos::kernel_params& ipr,
+    const double fgamma, const std::array<simd_t, OCTOTIGER_MAX_NUMBER_FIELDS>& q,
+    const simd_t& rhoinv, const simd_t& ek, simd_t& p, simd_t& cs) {
+    const simd_t ein = SIMD_NAMESPACE::max(q[egas_i] - ek, simd_t(ipr.eint_floor));
+    // sum over rho_s / mu_s = rho / mu_avg
+    simd_t rho_mu_inv = 0.0;
+    for (int s = 0; s < ipr.n_species; s++) {
+        rho_mu_inv += q[spc_i + s] * ipr.mu_inv[s];
+    }
+    const simd_t a_gas = ipr.ideal_coeff * rho_mu_inv / (fgamma - 1.0);
+    const simd_t t_rad = simd_fallbacks::sqrt_with_serial_fallback(
+        simd_fallbacks::sqrt_with_serial_fallback(ein / ipr.rad_coeff));
+    const simd_t lambda = a_gas * t_rad / ein;
+
+    // Gather table nodes
+    std::array<double, simd_t::size()> lambda_helper;
+    std::array<double, simd_t::size()> s_helper;
+    std::array<double, simd_t::size()> x0_helper;
+    std::array<double, simd_t::size()> d0_helper;
+    std::array<double, simd_t::size()> x1_helper;
+    std::array<double, simd_t::size()> d1_helper;
+    std::array<double, simd_t::size()> region_helper;
+    lambda.copy_to(lambda_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+    for (int i = 0; i < simd_t::size(); i++) {
+        const double t = (std::log(lambda_helper[i]) - ipr_eos::log_lambda_min) / ipr_eos::dlog_lambda;
+        region_helper[i] = t <= 0.0 ? -1.0 : (t >= ipr_eos::table_size - 1 ? 1.0 : 0.0);
+        int node = region_helper[i] == 0.0 ? static_cast<int>(t) : 0;
+        node = node < ipr_eos::table_size - 2 ? node : ipr_eos::table_size - 2;
+        s_helper[i] = region_helper[i] == 0.0 ? t - node : 0.0;
+        x0_helper[i] = ipr.x[node];
+        d0_helper[i] = ipr.dx_dlog_lambda[node];
+        x1_helper[i] = ipr.x[node + 1];
+        d1_helper[i] = ipr.dx_dlog_lambda[node + 1];
+    }
+    const simd_t s(s_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+    const simd_t x0(x0_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+    const simd_t d0(d0_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+    const simd_t x1(x1_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+    const simd_t d1(d1_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+    const simd_t region(region_helper.data(), SIMD_NAMESPACE::element_aligned_tag{});
+
+    const simd_t s2 = s * s;
+    const simd_t s3 = s2 * s;
+    simd_t x = (2.0 * s3 - 3.0 * s2 + 1.0) * x0 + (s3 - 2.0 * s2 + s) * ipr_eos::dlog_lambda * d0 +
+        (3.0 * s2 - 2.0 * s3) * x1 + (s3 - s2) * ipr_eos::dlog_lambda * d1;
+    // Asymptotic solutions outside the table range
+    const simd_t lambda_inv = 1.0 / lambda;
+    const simd_t lambda_inv4 = lambda_inv * lambda_inv * lambda_inv * lambda_inv;
+    x = SIMD_NAMESPACE::choose(region < simd_t(0.0), 1.0 - 0.25 * lambda, x);
+    x = SIMD_NAMESPACE::choose(simd_t(0.0) < region, lambda_inv * (1.0 - lambda_inv4), x);
+    if (ipr.polish) {
+        const simd_t x3 = x * x * x;
+        x = x - (lambda * x + x3 * x - 1.0) / (lambda + 4.0 * x3);
+    }
+    const simd_t t = t_rad * x;
+
+    const simd_t pgas = ipr.ideal_coeff * rho_mu_inv * t;
+    p = pgas + ipr.rad_coeff * t * t * t * t / 3.0;
+    // adiabatic index, Kippenhahn chapter 13.2
+    const simd_t beta = pgas / p;
+    const simd_t gamma1_tmp1 = 4.0 / 3.0 + beta / 6.0;
+    const simd_t beta_safe = SIMD_NAMESPACE::max(beta, simd_t(0.001));
+    const simd_t alpha = 1.0 / beta_safe;
+    const simd_t delta = (4.0 - 3.0 * beta_safe) * alpha;
+    const simd_t nab_ad = (1.0 + (1.0 - beta_safe) * (4.0 + beta_safe) * alpha * alpha) /
+        (fgamma / (fgamma - 1.0) + 4.0 * (1.0 - beta_safe) * (4.0 + beta_safe) * alpha * alpha);
+    const simd_t gamma1_tmp2 = 1.0 / (alpha - delta * nab_ad);
+    const simd_t gamma1 = SIMD_NAMESPACE::choose(simd_t(0.001) < beta, gamma1_tmp2, gamma1_tmp1);
+    cs = simd_fallbacks::sqrt_with_serial_fallback(p * gamma1 * rhoinv);
+}
+
 template <typename simd_t>
 CUDA_GLOBAL_METHOD inline simd_t cell_inner_flux_loop_simd(const double omega, const size_t nf_,
     const double A_, const double B_, const std::array<simd_t, OCTOTIGER_MAX_NUMBER_FIELDS>& local_q,
@@ -61,7 +140,7 @@ CUDA_GLOBAL_METHOD inline simd_t cell_inner_flux_loop_simd(const double omega, c
     std::array<simd_t, OCTOTIGER_MAX_NUMBER_FIELDS> &this_flux, const std::array<simd_t, NDIM>& x,
     const std::array<simd_t, NDIM>& vg, simd_t& ap, simd_t& am, const size_t dim, const size_t d,
     const double dx, const double fgamma, const double de_switch_1,
-    const size_t face_offset) {
+    const size_t face_offset, const ipr_eos::kernel_params& ipr = ipr_eos::kernel_params{}) {
     simd_t amr, apr, aml, apl;
     simd_t this_ap, this_am;    // tmps
 
@@ -72,30 +151,7 @@ CUDA_GLOBAL_METHOD inline simd_t cell_inner_flux_loop_simd(const double omega, c
 
     // all workitems choose the same path
     if (A_ != 0.0) {
-      // TODO Renable support for different EoS
-      // probaly by adding serial fallback for the missing math functins
-        const auto Binv = 1.0 / B_;
-        const auto x = simd_fallbacks::pow_with_serial_fallback(rho * Binv, 1.0 / 3.0);
-
-        const auto x_sqr = x * x;
-        const auto x_sqr_sqrt = simd_fallbacks::sqrt_with_serial_fallback(x_sqr + simd_t(1.0));
-        const auto x_pow_5 = x_sqr * x_sqr * x;
-        const simd_t hdeg = 8.0 * A_ * Binv * (x_sqr_sqrt - 1.0);
-
-        const simd_t pdeg_tmp1 =
-            A_ * (x * (2.0 * x_sqr - 3.0) * x_sqr_sqrt + 3.0 *
-                simd_fallbacks::asinh_with_serial_fallback(x));
-        const simd_t pdeg_tmp2 = 1.6 * A_ * x_pow_5;
-
-        const auto pdeg_mask = x < simd_t(0.001);
-        pdeg = SIMD_NAMESPACE::choose(pdeg_mask, pdeg_tmp2, pdeg_tmp1);
-
-        const simd_t edeg_tmp1 = rho * hdeg - pdeg;
-        const simd_t edeg_tmp2 = 2.4 * A_ * x_pow_5;
-        const auto edeg_mask = simd_t(0.001) < x;
-        edeg = SIMD_NAMESPACE::choose(edeg_mask, edeg_tmp1, edeg_tmp2);
-
-        dpdeg_drho = 8.0 / 3.0 * A_ * Binv * x_sqr / x_sqr_sqrt;
+        wd_eos::state(A_, B_, rho, pdeg, edeg, dpdeg_drho);
     }
     simd_t ek = 0.0;
     simd_t ein;
@@ -103,22 +159,27 @@ CUDA_GLOBAL_METHOD inline simd_t cell_inner_flux_loop_simd(const double omega, c
         ek += local_q[(sx_i + dim)] *
             local_q[(sx_i + dim)] * rhoinv * 0.5;
     }
-    const auto ein1_tmp2 = local_q[egas_i] - ek - edeg;
-    const auto ein1_mask =
-        (ein1_tmp2 < (de_switch_1 * local_q[egas_i]));
-
-    if (SIMD_NAMESPACE::any_of(ein1_mask)) {
-        const auto ein1_tmp1 =
-            simd_fallbacks::pow_with_serial_fallback(local_q[tau_i], fgamma);
-        ein = SIMD_NAMESPACE::choose(ein1_mask, ein1_tmp1, ein1_tmp2);
+    simd_t p, c;
+    if (ipr.active) {
+        cell_ipr_eos_simd<simd_t>(ipr, fgamma, local_q, rhoinv, ek, p, c);
     } else {
-        ein = ein1_tmp2;
+        const auto ein1_tmp2 = local_q[egas_i] - ek - edeg;
+        const auto ein1_mask =
+            (ein1_tmp2 < (de_switch_1 * local_q[egas_i]));
+
+        if (SIMD_NAMESPACE::any_of(ein1_mask)) {
+            const auto ein1_tmp1 =
+                simd_fallbacks::pow_with_serial_fallback(local_q[tau_i], fgamma);
+            ein = SIMD_NAMESPACE::choose(ein1_mask, ein1_tmp1, ein1_tmp2);
+        } else {
+            ein = ein1_tmp2;
+        }
+        const auto dp_drho = dpdeg_drho + (fgamma - 1.0) * ein * rhoinv;
+        const auto dp_deps = (fgamma - 1.0) * rho;
+        p = (fgamma - 1.0) * ein + pdeg;
+        c = simd_fallbacks::sqrt_with_serial_fallback(p * rhoinv * rhoinv * dp_deps + dp_drho);
     }
-    const auto dp_drho = dpdeg_drho + (fgamma - 1.0) * ein * rhoinv;
-    const auto dp_deps = (fgamma - 1.0) * rho;
     const auto v0 = local_q[(sx_i + dim)] * rhoinv;
-    const auto p = (fgamma - 1.0) * ein + pdeg;
-    const auto c = simd_fallbacks::sqrt_with_serial_fallback(p * rhoinv * rhoinv * dp_deps + dp_drho);
     const auto v = v0 - vg[dim];
     amr = v - c;
     apr = v + c;
@@ -132,47 +193,33 @@ CUDA_GLOBAL_METHOD inline simd_t cell_inner_flux_loop_simd(const double omega, c
     // all workitems choose the same path
     // from to_prim
     if (A_ != 0.0) {
-        const auto Binv = 1.0 / B_;
-        const auto x = simd_fallbacks::pow_with_serial_fallback(rho * Binv, 1.0 / 3.0);
-
-        const auto x_sqr = x * x;
-        const auto x_sqr_sqrt = simd_fallbacks::sqrt_with_serial_fallback(x_sqr + 1.0);
-        const auto x_pow_5 = x_sqr * x_sqr * x;
-        const simd_t hdeg = 8.0 * A_ * Binv * (x_sqr_sqrt - 1.0);
-
-        const simd_t pdeg_tmp1 =
-            A_ * (x * (2.0 * x_sqr - 3.0) * x_sqr_sqrt + 3.0 * simd_fallbacks::asinh_with_serial_fallback(x));
-        const simd_t pdeg_tmp2 = 1.6 * A_ * x_pow_5;
-        const auto pdeg_mask = x < simd_t(0.001);
-        pdeg = SIMD_NAMESPACE::choose(pdeg_mask, pdeg_tmp2, pdeg_tmp1);
-
-        const simd_t edeg_tmp1 = rho * hdeg - pdeg;
-        const simd_t edeg_tmp2 = 2.4 * A_ * x_pow_5;
-        const auto edeg_mask = simd_t(0.001) < x;
-        edeg = SIMD_NAMESPACE::choose(edeg_mask, edeg_tmp1, edeg_tmp2);
-
-        dpdeg_drho = 8.0 / 3.0 * A_ * Binv * x_sqr / x_sqr_sqrt;
+        wd_eos::state(A_, B_, rho, pdeg, edeg, dpdeg_drho);
     }
     ek = 0.0;
     for (int dim = 0; dim < NDIM; dim++) {
         ek += local_q_flipped[(sx_i + dim)] *
             local_q_flipped[(sx_i + dim)] * rhoinv * 0.5;
     }
-    const auto ein2_tmp2 =
-        local_q_flipped[egas_i] - ek - edeg;
-    const auto ein2_mask =
-        (ein2_tmp2 < (de_switch_1 * local_q_flipped[egas_i]));
-    if (SIMD_NAMESPACE::any_of(ein2_mask)) {
-        const auto ein2_tmp1 = simd_fallbacks::pow_with_serial_fallback(local_q_flipped[tau_i], fgamma);
-        ein = SIMD_NAMESPACE::choose(ein2_mask, ein2_tmp1, ein2_tmp2);
+    simd_t p2, c2;
+    if (ipr.active) {
+        cell_ipr_eos_simd<simd_t>(ipr, fgamma, local_q_flipped, rhoinv, ek, p2, c2);
     } else {
-        ein = ein2_tmp2;
+        const auto ein2_tmp2 =
+            local_q_flipped[egas_i] - ek - edeg;
+        const auto ein2_mask =
+            (ein2_tmp2 < (de_switch_1 * local_q_flipped[egas_i]));
+        if (SIMD_NAMESPACE::any_of(ein2_mask)) {
+            const auto ein2_tmp1 = simd_fallbacks::pow_with_serial_fallback(local_q_flipped[tau_i], fgamma);
+            ein = SIMD_NAMESPACE::choose(ein2_mask, ein2_tmp1, ein2_tmp2);
+        } else {
+            ein = ein2_tmp2;
+        }
+        const auto dp_drho2 = dpdeg_drho + (fgamma - 1.0) * ein * rhoinv;
+        const auto dp_deps2 = (fgamma - 1.0) * rho;
+        p2 = (fgamma - 1.0) * ein + pdeg;
+        c2 = simd_fallbacks::sqrt_with_serial_fallback(p2 * rhoinv * rhoinv * dp_deps2 + dp_drho2);
     }
-    const auto dp_drho2 = dpdeg_drho + (fgamma - 1.0) * ein * rhoinv;
-    const auto dp_deps2 = (fgamma - 1.0) * rho;
     const auto v02 = local_q_flipped[(sx_i + dim)] * rhoinv;
-    const auto p2 = (fgamma - 1.0) * ein + pdeg;
-    const auto c2 = simd_fallbacks::sqrt_with_serial_fallback(p2 * rhoinv * rhoinv * dp_deps2 + dp_drho2);
     const auto v2 = v02 - vg[dim];
     aml = v2 - c2;
     apl = v2 + c2;
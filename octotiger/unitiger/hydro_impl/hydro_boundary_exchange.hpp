@@ -17,11 +17,11 @@
 #include "octotiger/util/vec_base_wrapper.hpp"
 
 void complete_hydro_amr_boundary_cpu(const double dx, const bool energy_only,
-    const std::vector<std::vector<real>>& ushad, const std::vector<int>& is_coarse,
-    const std::array<double, NDIM>& xmin, std::vector<std::vector<real>>& u);
+    const std::vector<std::vector<real>>& ushad, const coarse_mask& is_coarse,
+    const std::array<double, NDIM>& xmin, field_view<real> u);
 void complete_hydro_amr_boundary_vc(const double dx, const bool energy_only,
-    const std::vector<std::vector<real>>& Ushad, const std::vector<int>& is_coarse,
-    const std::array<double, NDIM>& xmin, std::vector<std::vector<double>>& U);
+    const std::vector<std::vector<real>>& Ushad, const coarse_mask& is_coarse,
+    const std::array<double, NDIM>& xmin, field_view<real> U);
 #ifdef OCTOTIGER_HAVE_CUDA
 
 #include <aggregation_manager.hpp>
@@ -34,8 +34,8 @@ complete_hydro_amr_cuda_kernel(const double dx, const bool energy_only,
 void launch_complete_hydro_amr_boundary_cuda(
     double dx,
     bool energy_only, const std::vector<std::vector<real>>& ushad,
-    const std::vector<int>& is_coarse, const std::array<double, NDIM>& xmin,
-    std::vector<std::vector<real>>& u);
+    const coarse_mask& is_coarse, const std::array<double, NDIM>& xmin,
+    field_view<real> u);
 void launch_complete_hydro_amr_boundary_cuda_post(
     aggregated_executor_t& executor,
     dim3 const grid_spec, dim3 const threads_per_block, void *args[]);
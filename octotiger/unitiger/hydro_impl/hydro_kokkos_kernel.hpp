@@ -122,7 +122,8 @@ void flux_impl_teamless(hpx::kokkos::executor<kokkos_backend_t>& executor,
     kokkos_buffer_t& amax, kokkos_int_buffer_t& amax_indices, kokkos_int_buffer_t& amax_d,
     const kokkos_mask_t& masks, const double omega, const kokkos_buffer_t& dx,
     const double A_, const double B_, const int nf, const double fgamma, const double de_switch_1,
-    const int number_blocks, const int team_size
+    const int number_blocks, const int team_size,
+    const ipr_eos::kernel_params ipr = ipr_eos::kernel_params{}
     ) {
     // Supported team_sizes need to be the power of two! Team size of 1 is a special case for usage
     // with the serial kokkos backend:
@@ -245,7 +246,7 @@ void flux_impl_teamless(hpx::kokkos::executor<kokkos_backend_t>& executor,
                             cell_inner_flux_loop_simd<simd_t>(omega, nf, A_, B_, local_q, local_q_flipped,
                                 local_f, local_x, local_vg, this_ap, this_am, dim, d, dx[slice_id],
                                 fgamma, de_switch_1,
-                                face_offset);
+                                face_offset, ipr);
 
                             // Update maximum values
                             this_ap = SIMD_NAMESPACE::choose(mask, this_ap, simd_t(0.0));
@@ -1050,9 +1051,11 @@ timestep_t device_interface_kokkos_hydro(executor_t& exec,
     aggregated_host_buffer<int, executor_t> amax_indices(alloc_host_int, blocks * max_slices);
     aggregated_host_buffer<int, executor_t> amax_d(alloc_host_int, blocks * max_slices);
 
+    // IPR eos is only supported on the host (uses the tabulated temperature inversion)
+    const ipr_eos::kernel_params ipr = physics<NDIM>::get_ipr_kernel_params();
     flux_impl_teamless<host_simd_t, host_simd_mask_t>(exec, agg_exec, q, combined_x, f,
         amax, amax_indices, amax_d, masks, omega, dx, A_, B_, nf, fgamma,
-        de_switch_1, blocks, 1);
+        de_switch_1, blocks, 1, ipr);
 
     sync_kokkos_host_kernel(exec);
 
@@ -1098,9 +1101,9 @@ timestep_t device_interface_kokkos_hydro(executor_t& exec,
 // Output F
 template <typename executor_t>
 timestep_t launch_hydro_kokkos_kernels(const hydro_computer<NDIM, INX, physics<NDIM>>& hydro,
-    const std::vector<std::vector<safe_real>>& U, const std::vector<std::vector<safe_real>>& X,
+    field_view<const safe_real> U, const std::vector<std::vector<safe_real>>& X,
     const double omega, const size_t n_species, executor_t& executor,
-    std::vector<hydro_state_t<std::vector<safe_real>>>& F) {
+    std::vector<field_storage<safe_real>>& F) {
     static const cell_geometry<NDIM, INX> geo;
 
     auto executor_slice_fut = hydro_kokkos_agg_executor_pool<executor_t>::request_executor_slice();
@@ -1152,10 +1155,7 @@ timestep_t launch_hydro_kokkos_kernels(const hydro_computer<NDIM, INX, physics<N
           std::copy(X[n].begin(), X[n].end(),
               combined_large_x.data() + n * H_N3 + large_x_slice_offset * slice_id);
       }
-      for (int f = 0; f < hydro.get_nf(); f++) {
-          std::copy(
-              U[f].begin(), U[f].end(), combined_u.data() + f * H_N3 + u_slice_offset * slice_id);
-      }
+      copy_fields(U, hydro.get_nf(), combined_u.data() + u_slice_offset * slice_id, H_N3);
       const auto& disc_detect_bool = hydro.get_disc_detect();
       const auto& smooth_bool = hydro.get_smooth_field();
       for (auto f = 0; f < hydro.get_nf(); f++) {
@@ -7,6 +7,7 @@
 
 #pragma once
 #include "octotiger/common_kernel/kokkos_simd.hpp"
+#include "octotiger/unitiger/hydro_impl/wd_eos_kernel_templates.hpp"
 #if defined(__clang__)
 constexpr int number_dirs = 27;
 constexpr int inx_large = INX + 6;
@@ -107,13 +108,7 @@ CUDA_CALLABLE_METHOD const int xloc[27][3] = {
 // Utility functions
 
 CUDA_GLOBAL_METHOD inline double deg_pres(double x, double A_) {
-    double p;
-    if (x < 0.001) {
-        p = 1.6 * A_ * pow(x, 5);
-    } else {
-        p = A_ * (x * (2 * x * x - 3) * sqrt(x * x + 1) + 3 * asinh(x));
-    }
-    return p;
+    return wd_eos::pressure(A_, x);
 }
 CUDA_GLOBAL_METHOD inline int to_q_index(const int j, const int k, const int l) {
     return j * q_inx * q_inx + k * q_inx + l;
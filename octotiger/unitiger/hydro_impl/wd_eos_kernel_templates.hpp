@@ -0,0 +1,125 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cmath>
+
+#include "octotiger/cuda_util/cuda_global_def.hpp"
+#include "octotiger/common_kernel/kokkos_simd.hpp"
+
+// White dwarf (zero temperature, fully degenerate electron gas) eos for the hydro kernels.
+//
+// All functions are templated on the value type and work for both plain doubles (legacy and CUDA
+// kernels) and the Kokkos SIMD types (host SIMD kernels). The asinh in the degenerate pressure is
+// evaluated with branch-free arithmetic only (see fast_asinh), so the SIMD path no longer falls
+// back to a serial std::asinh per lane.
+namespace wd_eos {
+
+namespace detail {
+CUDA_GLOBAL_METHOD inline double select(const bool mask, const double a, const double b) {
+    return mask ? a : b;
+}
+template <typename mask_t, typename simd_t>
+CUDA_GLOBAL_METHOD inline simd_t select(const mask_t& mask, const simd_t& a, const simd_t& b) {
+    return SIMD_NAMESPACE::choose(mask, a, b);
+}
+CUDA_GLOBAL_METHOD inline double sqrt(const double x) {
+    return std::sqrt(x);
+}
+template <typename simd_t>
+CUDA_GLOBAL_METHOD inline simd_t sqrt(const simd_t& x) {
+    return simd_fallbacks::sqrt_with_serial_fallback(x);
+}
+CUDA_GLOBAL_METHOD inline double pow(const double x, const double e) {
+    return std::pow(x, e);
+}
+template <typename simd_t>
+CUDA_GLOBAL_METHOD inline simd_t pow(const simd_t& x, const double e) {
+    return simd_fallbacks::pow_with_serial_fallback(x, e);
+}
+
+/// Divides y by 2^e wherever y >= 2^e and accumulates e in k (exact, only scales by powers of two)
+template <typename T>
+CUDA_GLOBAL_METHOD inline void reduce_by_pow2(T& y, T& k, const double pow2, const double e) {
+    const auto mask = y < T(pow2);
+    y = select(mask, y, T(y * (1.0 / pow2)));
+    k = select(mask, k, T(k + e));
+}
+}    // namespace detail
+
+/// asinh(x) for x >= 0 using only arithmetic, compares and selects.
+///
+/// asinh(x) = ln(y) with y = x + sqrt(x^2 + 1). y is reduced to m * 2^k with m in [1/sqrt(2), sqrt(2))
+/// and ln(m) = 2 atanh(t), t = (m - 1) / (m + 1), |t| < 0.172, is summed to t^23. For unreduced
+/// arguments m - 1 is computed as x + x^2 / (sqrt(x^2 + 1) + 1) to avoid cancellation for small x.
+/// The relative error against std::asinh is below 1e-15 for 0 <= x < 2^511 (checked by test_problems/wd_eos).
+template <typename T>
+CUDA_GLOBAL_METHOD inline T fast_asinh(const T& x, const T& x_sqr_sqrt) {
+    constexpr double sqrt2 = 1.41421356237309504880;
+    constexpr double ln2 = 0.69314718055994530942;
+    T y = x + x_sqr_sqrt;
+    T k = T(0.0);
+    detail::reduce_by_pow2(y, k, 0x1p256, 256.0);
+    detail::reduce_by_pow2(y, k, 0x1p128, 128.0);
+    detail::reduce_by_pow2(y, k, 0x1p64, 64.0);
+    detail::reduce_by_pow2(y, k, 0x1p32, 32.0);
+    detail::reduce_by_pow2(y, k, 0x1p16, 16.0);
+    detail::reduce_by_pow2(y, k, 0x1p8, 8.0);
+    detail::reduce_by_pow2(y, k, 0x1p4, 4.0);
+    detail::reduce_by_pow2(y, k, 0x1p2, 2.0);
+    detail::reduce_by_pow2(y, k, 0x1p1, 1.0);
+    // y is in [1, 2) now, move it to [1/sqrt(2), sqrt(2))
+    const auto keep = y < T(sqrt2);
+    y = detail::select(keep, y, T(0.5 * y));
+    k = detail::select(keep, k, T(k + 1.0));
+    const auto unreduced = k < T(0.5);
+    const T ym1 = detail::select(unreduced, T(x + x * x / (x_sqr_sqrt + 1.0)), T(y - 1.0));
+    const T t = ym1 / (ym1 + 2.0);
+    const T t2 = t * t;
+    T s = T(1.0 / 23.0);
+    s = s * t2 + 1.0 / 21.0;
+    s = s * t2 + 1.0 / 19.0;
+    s = s * t2 + 1.0 / 17.0;
+    s = s * t2 + 1.0 / 15.0;
+    s = s * t2 + 1.0 / 13.0;
+    s = s * t2 + 1.0 / 11.0;
+    s = s * t2 + 1.0 / 9.0;
+    s = s * t2 + 1.0 / 7.0;
+    s = s * t2 + 1.0 / 5.0;
+    s = s * t2 + 1.0 / 3.0;
+    s = s * t2 + 1.0;
+    return k * ln2 + 2.0 * t * s;
+}
+
+/// Degenerate pressure for the dimensionless Fermi momentum x = (rho / B)^(1/3)
+template <typename T>
+CUDA_GLOBAL_METHOD inline T pressure(const double A, const T& x) {
+    const T x_sqr = x * x;
+    const T x_sqr_sqrt = detail::sqrt(T(x_sqr + 1.0));
+    const T p_small = 1.6 * A * x_sqr * x_sqr * x;
+    const T p_large = A * (x * (2.0 * x_sqr - 3.0) * x_sqr_sqrt + 3.0 * fast_asinh(x, x_sqr_sqrt));
+    return detail::select(x < T(0.001), p_small, p_large);
+}
+
+/// Degenerate pressure, internal energy density and dp/drho at density rho
+template <typename T>
+CUDA_GLOBAL_METHOD inline void state(
+    const double A, const double B, const T& rho, T& pdeg, T& edeg, T& dpdeg_drho) {
+    const double Binv = 1.0 / B;
+    const T x = detail::pow(T(rho * Binv), 1.0 / 3.0);
+    const T x_sqr = x * x;
+    const T x_sqr_sqrt = detail::sqrt(T(x_sqr + 1.0));
+    const T x_pow_5 = x_sqr * x_sqr * x;
+    const T hdeg = 8.0 * A * Binv * (x_sqr_sqrt - 1.0);
+
+    const T pdeg_large =
+        A * (x * (2.0 * x_sqr - 3.0) * x_sqr_sqrt + 3.0 * fast_asinh(x, x_sqr_sqrt));
+    pdeg = detail::select(x < T(0.001), T(1.6 * A * x_pow_5), pdeg_large);
+    edeg = detail::select(T(0.001) < x, T(rho * hdeg - pdeg), T(2.4 * A * x_pow_5));
+    dpdeg_drho = 8.0 / 3.0 * A * Binv * x_sqr / x_sqr_sqrt;
+}
+
+}    // namespace wd_eos
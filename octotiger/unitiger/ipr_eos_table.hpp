@@ -0,0 +1,136 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef OCTOTIGER_UNITIGER_IPR_EOS_TABLE_HPP_
+#define OCTOTIGER_UNITIGER_IPR_EOS_TABLE_HPP_
+
+#include "octotiger/cuda_util/cuda_global_def.hpp"
+
+#include <array>
+#include <cmath>
+
+// Tabulated inversion of the ideal gas plus radiation (IPR) eos.
+//
+// The internal energy e = a_gas * T + a_rad * T^4 (with a_gas = k_b / m_h * rho / (mu * (gamma - 1))
+// and a_rad = 4 sigma / c) has to be inverted for T during every primitive recovery. Scaling
+// T = x * (e / a_rad)^(1/4) reduces this to the one-parameter problem
+//
+//         lambda * x + x^4 = 1,   lambda = a_gas / e * (e / a_rad)^(1/4),
+//
+// so a single table x(ln lambda) covers every (rho, e_int, mu) combination. The table stores x and
+// dx/dln(lambda) at equidistant nodes and is evaluated with cubic Hermite interpolation, optionally
+// followed by one Newton step on the reduced equation. Outside the table range the asymptotic
+// solutions for the radiation- (x = 1 - lambda / 4) and gas-dominated (x = 1 / lambda - 1 / lambda^5)
+// limits are used.
+namespace ipr_eos {
+
+constexpr int table_size = 1024;
+constexpr double log_lambda_min = -32.0;
+constexpr double log_lambda_max = 32.0;
+constexpr double dlog_lambda = (log_lambda_max - log_lambda_min) / (table_size - 1);
+
+struct table_t {
+	std::array<double, table_size> x;
+	std::array<double, table_size> dx_dlog_lambda;
+};
+
+/// Parameters required by the hydro kernels to evaluate the IPR eos from a reconstructed state
+struct kernel_params {
+	bool active = false;
+	bool polish = true;
+	double ideal_coeff = 0.0;
+	double rad_coeff = 0.0;
+	double eint_floor = 0.0;
+	int n_species = 0;
+	// Inverse of the molecular weight per species
+	double mu_inv[OCTOTIGER_MAX_NUMBER_FIELDS] = { };
+	const double *x = nullptr;
+	const double *dx_dlog_lambda = nullptr;
+};
+
+/// Solves lambda * x + x^4 = 1 with Newton-Raphson - only used for building the table
+inline double solve_reduced(const double lambda) {
+	// f is convex and increasing for x > 0 and min(1, 1/lambda) is an upper bound of the root,
+	// hence the iteration converges monotonically
+	double x = lambda < 1.0 ? 1.0 : 1.0 / lambda;
+	for (int i = 0; i < 200; i++) {
+		const auto x3 = x * x * x;
+		const auto dx = (lambda * x + x3 * x - 1.0) / (lambda + 4.0 * x3);
+		x -= dx;
+		if (std::abs(dx) <= 1.0e-16 * x) {
+			break;
+		}
+	}
+	return x;
+}
+
+inline table_t build_table() {
+	table_t table;
+	for (int i = 0; i < table_size; i++) {
+		const auto lambda = std::exp(log_lambda_min + i * dlog_lambda);
+		const auto x = solve_reduced(lambda);
+		table.x[i] = x;
+		table.dx_dlog_lambda[i] = -x * lambda / (lambda + 4.0 * x * x * x);
+	}
+	return table;
+}
+
+/// Lazily built (thread-safe) table shared by all kernels on this locality
+inline const table_t& get_table() {
+	static const table_t table = build_table();
+	return table;
+}
+
+/// Cubic Hermite interpolation between two neighbouring table nodes, s in [0,1)
+CUDA_GLOBAL_METHOD inline double hermite(const double x0, const double d0, const double x1, const double d1, const double s) {
+	const auto s2 = s * s;
+	const auto s3 = s2 * s;
+	return (2.0 * s3 - 3.0 * s2 + 1.0) * x0 + (s3 - 2.0 * s2 + s) * dlog_lambda * d0 + (3.0 * s2 - 2.0 * s3) * x1
+			+ (s3 - s2) * dlog_lambda * d1;
+}
+
+/// One Newton step on lambda * x + x^4 = 1
+CUDA_GLOBAL_METHOD inline double newton_polish(const double x, const double lambda) {
+	const auto x3 = x * x * x;
+	return x - (lambda * x + x3 * x - 1.0) / (lambda + 4.0 * x3);
+}
+
+CUDA_GLOBAL_METHOD inline double reduced_temperature(const double *xs, const double *dxs, const double lambda, const bool polish) {
+	const auto log_lambda = std::log(lambda);
+	double x;
+	if (log_lambda <= log_lambda_min) {
+		x = 1.0 - 0.25 * lambda;
+	} else if (log_lambda >= log_lambda_max) {
+		const auto lambda_inv = 1.0 / lambda;
+		const auto lambda_inv2 = lambda_inv * lambda_inv;
+		x = lambda_inv * (1.0 - lambda_inv2 * lambda_inv2);
+	} else {
+		const auto t = (log_lambda - log_lambda_min) / dlog_lambda;
+		int i = static_cast<int>(t);
+		i = i < table_size - 2 ? i : table_size - 2;
+		x = hermite(xs[i], dxs[i], xs[i + 1], dxs[i + 1], t - i);
+	}
+	if (polish) {
+		x = newton_polish(x, lambda);
+	}
+	return x;
+}
+
+/// Temperature for internal energy density ein = a_gas * T + a_rad * T^4
+CUDA_GLOBAL_METHOD inline double temperature(const double *xs, const double *dxs, const double a_gas, const double a_rad,
+		const double ein, const bool polish) {
+	const auto t_rad = std::sqrt(std::sqrt(ein / a_rad));
+	const auto lambda = a_gas * t_rad / ein;
+	return t_rad * reduced_temperature(xs, dxs, lambda, polish);
+}
+
+inline double temperature(const double a_gas, const double a_rad, const double ein, const bool polish) {
+	const auto &table = get_table();
+	return temperature(table.x.data(), table.dx_dlog_lambda.data(), a_gas, a_rad, ein, polish);
+}
+
+}
+
+#endif /* OCTOTIGER_UNITIGER_IPR_EOS_TABLE_HPP_ */
@@ -6,7 +6,9 @@
 #ifndef OCTOTIGER_UNITIGER_PHYSICS_HPP_
 #define OCTOTIGER_UNITIGER_PHYSICS_HPP_
 
+#include "octotiger/field_storage.hpp"
 #include "octotiger/unitiger/safe_real.hpp"
+#include "octotiger/unitiger/ipr_eos_table.hpp"
 #include "octotiger/test_problems/blast.hpp"
 #include "octotiger/test_problems/exact_sod.hpp"
 
@@ -73,18 +75,19 @@ struct physics {
 	static void physical_flux_experimental(const std::vector<safe_real> &U, std::vector<safe_real> &F, int dim, safe_real &am, safe_real &ap, std::array<safe_real, NDIM> &x,
 			std::array<safe_real, NDIM> &vg);
 
-	template<int INX>
-	static void post_process(hydro::state_type &U, const hydro::x_type& X, safe_real dx);
+	template<int INX, class state_t>
+	static void post_process(state_t &U, const hydro::x_type& X, safe_real dx);
 
 	static void set_degenerate_eos(safe_real, safe_real);
-        static void set_ideal_plus_rad_eos(safe_real, safe_real, safe_real, int, bool, safe_real);
+        static void set_ideal_plus_rad_eos(safe_real, safe_real, safe_real, int, bool, safe_real, bool = false, bool = true);
+	static ipr_eos::kernel_params get_ipr_kernel_params();
 
 	template<int INX>
 	static void source(hydro::state_type &dudt, const hydro::state_type &U, const hydro::flux_type &F, const hydro::x_type X, safe_real omega, safe_real dx);
 
 	/*** Reconstruct uses this - GPUize****/
-	template<int INX>
-	static const hydro::state_type& pre_recon(const hydro::state_type &U, const hydro::x_type X, safe_real omega, bool angmom);
+	template<int INX, class state_t>
+	static const typename owning_fields<state_t>::type& pre_recon(const state_t &U, const hydro::x_type X, safe_real omega, bool angmom);
 	/*** Reconstruct uses this - GPUize****/
 	template<int INX>
 	static void post_recon(std::vector<std::vector<std::vector<safe_real>>> &Q, const hydro::x_type X, safe_real omega, bool angmom);
@@ -97,8 +100,8 @@ struct physics {
 	template<int INX>
 	static void analytic_solution(test_type test, hydro::state_type &U, const hydro::x_type &X, safe_real time);
 
-	template<int INX>
-	static const std::vector<std::vector<double>>& find_contact_discs(const hydro::state_type &U);
+	template<int INX, class state_t>
+	static const std::vector<std::vector<double>>& find_contact_discs(const state_t &U);
 
 	static void set_n_species(int n);
 	static int get_n_species() {
@@ -137,6 +140,8 @@ public:
 	static int IPR_NR_maxiter;
 	static bool IPR_test;
 	static safe_real IPR_eint_floor;
+	static bool IPR_table;
+	static bool IPR_table_polish;
 	static std::vector<safe_real> mu_;
 	static safe_real GM_;
 	static safe_real deg_pres(safe_real x);
@@ -187,6 +192,12 @@ safe_real physics<NDIM>::IPR_eint_floor = 0.0;
 
 template<int NDIM>
 bool physics<NDIM>::IPR_test = false;
+
+template<int NDIM>
+bool physics<NDIM>::IPR_table = false;
+
+template<int NDIM>
+bool physics<NDIM>::IPR_table_polish = true;
 //
 
 template<int NDIM>
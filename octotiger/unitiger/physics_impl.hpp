@@ -16,6 +16,7 @@
 #include "octotiger/test_problems/blast.hpp"
 #include "octotiger/test_problems/exact_sod.hpp"
 #include "octotiger/profiler.hpp"
+#include "octotiger/unitiger/hydro_impl/wd_eos_kernel_templates.hpp"
 
 template<int NDIM>
 int physics<NDIM>::field_count() {
@@ -24,13 +25,7 @@ int physics<NDIM>::field_count() {
 
 template<int NDIM>
 safe_real physics<NDIM>::deg_pres(safe_real x) {
-	safe_real p;
-	if (x < 0.001) {
-		p = 1.6 * A_ * std::pow(x, 5);
-	} else {
-		p = A_ * (x * (2 * x * x - 3) * std::sqrt(x * x + 1) + 3 * asinh(x));
-	}
-	return p;
+	return wd_eos::pressure(A_, x);
 }
 
 template<int NDIM>
@@ -98,7 +93,9 @@ void physics<NDIM>::to_prim(std::vector<safe_real> u, safe_real &p, safe_real &v
 
 		const auto t0 = mu_avg * ein * (fgamma_ - 1.0) / (IPR_IC_ * rho); // the first guess assumes only thermal pressure
 		// gets temperature according to total internal energy by the Newton-Raphson method
-		auto t = pres_IPR(t0, 1.0, IPR_IC_ * rho / (mu_avg * ein * (fgamma_ - 1.0)), IPR_RC_ / ein, it_num, IPR_NR_tol, IPR_NR_maxiter);
+		auto t = IPR_table ?
+				ipr_eos::temperature(IPR_IC_ * rho / (mu_avg * (fgamma_ - 1.0)), IPR_RC_, ein, IPR_table_polish) :
+				pres_IPR(t0, 1.0, IPR_IC_ * rho / (mu_avg * ein * (fgamma_ - 1.0)), IPR_RC_ / ein, it_num, IPR_NR_tol, IPR_NR_maxiter);
 //		print("Tgas = %.15e,  %.15e * %.15e * %.15e + %.15e * %.15e^4 = %.15e\n", t0, IC_ / mu_avg / (fgamma_ - 1.0), rho, t, RC_, t, ein);
 //		printf("Newton solution: %15e after %i\n", t, it_num);		
 		p = IPR_IC_ * rho * t / mu_avg + IPR_RC_ * t * t * t * t / 3.0;
@@ -238,8 +235,8 @@ void physics<NDIM>::physical_flux_experimental(const std::vector<safe_real> &U,
 }
 
 template<int NDIM>
-template<int INX>
-void physics<NDIM>::post_process(hydro::state_type &U, const hydro::x_type &X, safe_real dx) {
+template<int INX, class state_t>
+void physics<NDIM>::post_process(state_t &U, const hydro::x_type &X, safe_real dx) {
 	static const cell_geometry<NDIM, INX> geo;
 	constexpr
 	auto dir = geo.direction();
@@ -274,7 +271,11 @@ void physics<NDIM>::post_process(hydro::state_type &U, const hydro::x_type &X, s
 			const auto t0 = mu_avg * ein * (fgamma_ - 1.0) / (IPR_IC_ * rho); // the first guess assumes only thermal pressure
                         // gets temperature according to total internal energy by the Newton-Raphson methoda
                         int it_num = 0;
-                        U[tau_i][i] = pres_IPR(t0, 1.0, IPR_IC_ * rho / (mu_avg * ein * (fgamma_ - 1.0)), IPR_RC_ / ein, it_num, IPR_NR_tol, IPR_NR_maxiter);
+                        if (IPR_table) {
+                        	U[tau_i][i] = ipr_eos::temperature(IPR_IC_ * rho / (mu_avg * (fgamma_ - 1.0)), IPR_RC_, ein, IPR_table_polish);
+                        } else {
+                        	U[tau_i][i] = pres_IPR(t0, 1.0, IPR_IC_ * rho / (mu_avg * ein * (fgamma_ - 1.0)), IPR_RC_ / ein, it_num, IPR_NR_tol, IPR_NR_maxiter);
+                        }
 		} else if (ein > de_switch_2 * egas_max) {
 			U[tau_i][i] = POWER(ein, 1.0 / fgamma_);
 		}
@@ -343,12 +344,12 @@ void physics<NDIM>::source(hydro::state_type &dudt, const hydro::state_type &U,
 /*** Reconstruct uses this - GPUize****/
 
 template<int NDIM>
-template<int INX>
-const hydro::state_type& physics<NDIM>::pre_recon(const hydro::state_type &U, const hydro::x_type X, safe_real omega, bool angmom) {
+template<int INX, class state_t>
+const typename owning_fields<state_t>::type& physics<NDIM>::pre_recon(const state_t &U, const hydro::x_type X, safe_real omega, bool angmom) {
 	PROFILE();
 	static const cell_geometry<NDIM, INX> geo;
 	static const auto indices = geo.find_indices(0, geo.H_NX);
-	static thread_local hydro::state_type V;
+	static thread_local typename owning_fields<state_t>::type V;
 	V = U;
 	for (int j = 0; j < geo.H_NX_X; j++) {
 		for (int k = 0; k < geo.H_NX_Y; k++) {
@@ -421,13 +422,40 @@ void physics<NDIM>::set_degenerate_eos(safe_real a, safe_real b) {
 }
 
 template<int NDIM>
-void physics<NDIM>::set_ideal_plus_rad_eos(safe_real ideal_coeff, safe_real rad_coeff, safe_real NR_tol, int NR_maxiter, bool eos_test, safe_real min_eint) {
+void physics<NDIM>::set_ideal_plus_rad_eos(safe_real ideal_coeff, safe_real rad_coeff, safe_real NR_tol, int NR_maxiter, bool eos_test, safe_real min_eint,
+		bool use_table, bool table_polish) {
         IPR_IC_ = ideal_coeff;
         IPR_RC_ = rad_coeff;
 	IPR_NR_tol = NR_tol;
 	IPR_NR_maxiter = NR_maxiter;
 	IPR_test = eos_test;
 	IPR_eint_floor = min_eint;
+	IPR_table = use_table;
+	IPR_table_polish = table_polish;
+	if (IPR_table) {
+		// build the inversion table once up front instead of inside the first hydro kernel
+		ipr_eos::get_table();
+	}
+}
+
+template<int NDIM>
+ipr_eos::kernel_params physics<NDIM>::get_ipr_kernel_params() {
+	ipr_eos::kernel_params params;
+	if (IPR_RC_ != 0.0 && IPR_table) {
+		const auto &table = ipr_eos::get_table();
+		params.active = true;
+		params.polish = IPR_table_polish;
+		params.ideal_coeff = IPR_IC_;
+		params.rad_coeff = IPR_RC_;
+		params.eint_floor = IPR_eint_floor;
+		params.n_species = n_species_;
+		for (int s = 0; s < n_species_; s++) {
+			params.mu_inv[s] = 1.0 / mu_[s];
+		}
+		params.x = table.x.data();
+		params.dx_dlog_lambda = table.dx_dlog_lambda.data();
+	}
+	return params;
 }
 
 
@@ -454,8 +482,8 @@ void physics<NDIM>::set_mu(std::vector<safe_real> atomic_mass, std::vector<safe_
 }
 
 template<int NDIM>
-template<int INX>
-const std::vector<std::vector<safe_real>>& physics<NDIM>::find_contact_discs(const hydro::state_type &U) {
+template<int INX, class state_t>
+const std::vector<std::vector<safe_real>>& physics<NDIM>::find_contact_discs(const state_t &U) {
 	PROFILE();
 	static const cell_geometry<NDIM, INX> geo;
 	auto dir = geo.direction();
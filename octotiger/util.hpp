@@ -6,6 +6,7 @@
 #ifndef UTILAA_HPP_
 #define UTILAA_HPP_
 
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/options.hpp"
 
 #include "octotiger/print.hpp"
@@ -42,8 +43,8 @@ int file_copy(const char* fin, const char* fout);
 
 template<class... Args>
 int lprint( const char* log, const char* str, Args&&...args) {
-    // run output on separate thread
-    auto f = hpx::threads::run_as_os_thread([&]() -> int
+    // run output on the I/O pool
+    auto f = io::submit([&]() -> int
     {
         if(!opts().disable_output) {
             FILE* fp = fopen (log, "at");
@@ -0,0 +1,185 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/bench_recorder.hpp"
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/node_server.hpp"
+#include "octotiger/options.hpp"
+#include "octotiger/util.hpp"
+
+#include <hpx/include/performance_counters.hpp>
+#include <hpx/include/runtime.hpp>
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Bytes put on the wire by all parcelports of all localities, -1 if HPX provides no such counter
+// (e.g. single locality runs or parcelports built without counters)
+std::int64_t bytes_sent_all_localities() {
+	std::int64_t bytes = -1;
+	for (const auto &id : options::all_localities) {
+		const auto locality = std::to_string(hpx::naming::get_locality_id_from_id(id));
+		for (const char *parcelport : { "tcp", "mpi", "lci" }) {
+			const std::string counter_name = "/data{locality#" + locality + "/total}/count/" + parcelport + "/sent";
+			try {
+				hpx::performance_counters::performance_counter count(counter_name);
+				const auto value = count.get_value<std::int64_t>().get();
+				bytes = (bytes < 0 ? 0 : bytes) + value;
+			} catch (...) {
+				// parcelport not available
+			}
+		}
+	}
+	return bytes;
+}
+
+std::string scenario_name() {
+	std::string name = to_string(opts().problem);
+	for (auto &c : name) {
+		c = std::tolower(c);
+	}
+	if (!opts().restart_filename.empty()) {
+		name += "_restart";
+	}
+	return name;
+}
+
+std::string json_string(const std::string &str) {
+	std::string rc = "\"";
+	for (const char c : str) {
+		if (c == '"' || c == '\\') {
+			rc += '\\';
+		}
+		rc += c;
+	}
+	return rc + "\"";
+}
+
+}
+
+bench_recorder::bench_recorder() :
+		bytes_sent_start(-1), bytes_sent(-1), measuring(false) {
+}
+
+bool bench_recorder::is_measured(integer step) {
+	return step >= opts().bench_warmup_steps;
+}
+
+bool bench_recorder::is_done(integer step) {
+	return step >= opts().bench_warmup_steps + opts().bench_steps;
+}
+
+void bench_recorder::start_measurement() {
+	if (measuring) {
+		return;
+	}
+	timings_reset_all();
+	bytes_sent_start = bytes_sent_all_localities();
+	measuring = true;
+}
+
+void bench_recorder::record_block(integer first_step, integer steps, double seconds, const node_count_type &ngrids) {
+	blocks.push_back(block_record { first_step, steps, seconds, 0.0, measuring, ngrids.total, ngrids.leaf, ngrids.amr_bnd });
+}
+
+void bench_recorder::record_regrid(double seconds) {
+	if (!blocks.empty()) {
+		blocks.back().regrid_seconds += seconds;
+	}
+}
+
+void bench_recorder::stop_measurement() {
+	if (!measuring) {
+		return;
+	}
+	phases = timings_collect_all();
+	const auto bytes_sent_stop = bytes_sent_all_localities();
+	bytes_sent = bytes_sent_start < 0 || bytes_sent_stop < 0 ? -1 : bytes_sent_stop - bytes_sent_start;
+	measuring = false;
+}
+
+void bench_recorder::write(const std::string &filename) const {
+	io::submit([&]() {
+		FILE *fp = fopen(filename.c_str(), "wt");
+		if (fp == nullptr) {
+			print("Unable to open %s for writing\n", filename.c_str());
+			return;
+		}
+		double total = 0.0;
+		int measured = 0;
+		for (const auto &b : blocks) {
+			if (b.measured) {
+				total += b.seconds + b.regrid_seconds;
+				measured += b.steps;
+			}
+		}
+
+		fprintf(fp, "{\n");
+		fprintf(fp, "  \"scenario\": %s,\n", json_string(scenario_name()).c_str());
+		fprintf(fp, "  \"restart_filename\": %s,\n", json_string(opts().restart_filename).c_str());
+		fprintf(fp, "  \"inx\": %i,\n", int(INX));
+		fprintf(fp, "  \"localities\": %i,\n", int(options::all_localities.size()));
+		fprintf(fp, "  \"threads_per_locality\": %i,\n", int(hpx::get_os_thread_count()));
+		fprintf(fp, "  \"options\": {\n");
+		fprintf(fp, "    \"max_level\": %i,\n", int(opts().max_level));
+		fprintf(fp, "    \"theta\": %e,\n", double(opts().theta));
+		fprintf(fp, "    \"gravity\": %s,\n", opts().gravity ? "true" : "false");
+		fprintf(fp, "    \"hydro\": %s,\n", opts().hydro ? "true" : "false");
+		fprintf(fp, "    \"radiation\": %s,\n", opts().radiation ? "true" : "false");
+		fprintf(fp, "    \"hydro_host_kernel_type\": %s,\n", json_string(to_string(opts().hydro_host_kernel_type)).c_str());
+		fprintf(fp, "    \"hydro_device_kernel_type\": %s,\n", json_string(to_string(opts().hydro_device_kernel_type)).c_str());
+		fprintf(fp, "    \"multipole_host_kernel_type\": %s,\n", json_string(to_string(opts().multipole_host_kernel_type)).c_str());
+		fprintf(fp, "    \"multipole_device_kernel_type\": %s,\n",
+				json_string(to_string(opts().multipole_device_kernel_type)).c_str());
+		fprintf(fp, "    \"monopole_host_kernel_type\": %s,\n", json_string(to_string(opts().monopole_host_kernel_type)).c_str());
+		fprintf(fp, "    \"monopole_device_kernel_type\": %s,\n", json_string(to_string(opts().monopole_device_kernel_type)).c_str());
+		fprintf(fp, "    \"amr_boundary_kernel_type\": %s,\n", json_string(to_string(opts().amr_boundary_kernel_type)).c_str());
+		fprintf(fp, "    \"cuda_number_gpus\": %i,\n", int(opts().cuda_number_gpus));
+		fprintf(fp, "    \"cuda_streams_per_gpu\": %i,\n", int(opts().cuda_streams_per_gpu));
+		fprintf(fp, "    \"cuda_buffer_capacity\": %i\n", int(opts().cuda_buffer_capacity));
+		fprintf(fp, "  },\n");
+		fprintf(fp, "  \"stepping\": \"blocks\",\n");
+		fprintf(fp, "  \"steps_per_block\": %i,\n", int(refinement_freq()));
+		fprintf(fp, "  \"warmup_steps\": %i,\n", int(opts().bench_warmup_steps));
+		fprintf(fp, "  \"measured_steps\": %i,\n", measured);
+		fprintf(fp, "  \"measured_seconds\": %.9e,\n", total);
+		fprintf(fp, "  \"mean_step_seconds\": %.9e,\n", measured ? total / measured : 0.0);
+		fprintf(fp, "  \"bytes_sent\": %lli,\n", static_cast<long long>(bytes_sent));
+
+		// Blocks with their wall time and the mean time per step of the block
+		fprintf(fp, "  \"blocks\": [");
+		for (std::size_t i = 0; i < blocks.size(); i++) {
+			const auto &b = blocks[i];
+			fprintf(fp,
+					"%s\n    {\"first_step\": %i, \"steps\": %i, \"measured\": %s, \"seconds\": %.9e, \"step_seconds\": %.9e, "
+							"\"regrid_seconds\": %.9e, \"nodes\": %llu, \"leaves\": %llu, \"amr_boundaries\": %llu}", i ? "," : "",
+					int(b.first_step), int(b.steps), b.measured ? "true" : "false", b.seconds, b.steps > 0 ? b.seconds / b.steps : 0.0,
+					b.regrid_seconds, static_cast<unsigned long long>(b.nodes), static_cast<unsigned long long>(b.leaves),
+					static_cast<unsigned long long>(b.amr_boundaries));
+		}
+		fprintf(fp, "\n  ],\n");
+
+		// Per phase min/max/mean over the nodes of each locality
+		fprintf(fp, "  \"phases\": [");
+		for (std::size_t l = 0; l < phases.size(); l++) {
+			const auto &r = phases[l];
+			fprintf(fp, "%s\n    {\"locality\": %i, \"nodes\": %llu, \"timers\": {", l ? "," : "", int(l),
+					static_cast<unsigned long long>(r.nodes_));
+			for (std::size_t t = 0; t < timings::time_last; ++t) {
+				const double mean = r.nodes_ ? r.sum_.get(t) / r.nodes_ : 0.0;
+				fprintf(fp, "%s\n      \"%s\": {\"min\": %.9e, \"max\": %.9e, \"mean\": %.9e}", t ? "," : "", timings::name(t),
+						r.min_.get(t), r.max_.get(t), mean);
+			}
+			fprintf(fp, "\n    }}");
+		}
+		fprintf(fp, "\n  ]\n}\n");
+		fclose(fp);
+		print("Benchmark results written to %s\n", filename.c_str());
+	}).get();
+}
@@ -0,0 +1,81 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/comm_counters.hpp"
+
+#include <hpx/include/performance_counters.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace comm_counters {
+
+namespace {
+
+enum counter_kind {
+	local_messages, local_bytes, remote_messages, remote_bytes, kind_count
+};
+
+const char* kind_names[kind_count] = { "local/messages", "local/bytes", "remote/messages", "remote/bytes" };
+
+const char* kind_descriptions[kind_count] = { "number of messages sent to components on this locality",
+		"payload bytes sent to components on this locality", "number of messages sent to other localities",
+		"payload bytes sent to other localities" };
+
+// One cache line per action, sends of different actions from different threads do not contend
+struct alignas(64) action_counters {
+	std::array<std::atomic<std::uint64_t>, kind_count> c;
+};
+
+std::array<action_counters, action_count> counters;
+
+template <std::size_t Action, std::size_t Kind>
+std::uint64_t counter_value(bool reset) {
+	auto& c = counters[Action].c[Kind];
+	return reset ? c.exchange(0, std::memory_order_relaxed) : c.load(std::memory_order_relaxed);
+}
+
+using counter_function = std::uint64_t (*)(bool);
+
+template <std::size_t Action, std::size_t ... Kinds>
+constexpr std::array<counter_function, kind_count> action_functions(std::index_sequence<Kinds...>) {
+	return { { &counter_value<Action, Kinds>... } };
+}
+
+template <std::size_t ... Actions>
+constexpr std::array<std::array<counter_function, kind_count>, action_count> all_functions(std::index_sequence<Actions...>) {
+	return { { action_functions<Actions>(std::make_index_sequence<kind_count>())... } };
+}
+
+}
+
+const char* name(action_type action) {
+	static const char* names[action_count] = { "hydro_boundary", "hydro_amr_boundary", "hydro_children",
+			"hydro_flux_correct", "flux_check", "gravity_boundary", "gravity_multipoles", "gravity_expansions",
+			"rad_boundary", "rad_amr_boundary", "rad_children", "rad_flux_correct" };
+	return names[action];
+}
+
+void record(action_type action, bool is_local, std::size_t bytes) {
+	auto& c = counters[action].c;
+	c[is_local ? local_messages : remote_messages].fetch_add(1, std::memory_order_relaxed);
+	c[is_local ? local_bytes : remote_bytes].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void register_counters() {
+	static constexpr auto functions = all_functions(std::make_index_sequence<action_count>());
+	for (int a = 0; a < action_count; a++) {
+		for (int k = 0; k < kind_count; k++) {
+			const std::string counter_name = std::string("/octotiger/comm/") + name(action_type(a)) + "/" + kind_names[k];
+			const std::string description = std::string(kind_descriptions[k]) + " by send_" + name(action_type(a)) + "_action";
+			hpx::performance_counters::install_counter_type(counter_name, functions[a][k], description);
+		}
+	}
+}
+
+}
@@ -0,0 +1,103 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/conserved_sums.hpp"
+#include "octotiger/options.hpp"
+#include "octotiger/print.hpp"
+#include "octotiger/telemetry.hpp"
+
+#include <hpx/include/actions.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/runtime.hpp>
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct sample {
+	real time = 0.0;
+	conserved_sums_t sums;
+};
+
+std::mutex samples_mtx;
+std::map<integer, sample> samples;
+
+// First complete sample, the reference of the drift
+bool have_reference = false;
+conserved_sums_t reference;
+
+real relative_drift(integer f, const conserved_sums_t& s) {
+	const real ref = reference.fields[f];
+	return ref != 0.0 ? (s.fields[f] - ref) / std::abs(ref) : s.fields[f];
+}
+
+}
+
+conserved_sums_t& conserved_sums_t::operator+=(const conserved_sums_t& other) {
+	if (fields.empty()) {
+		fields.assign(other.fields.size(), 0.0);
+	}
+	for (std::size_t f = 0; f < fields.size(); f++) {
+		fields[f] += other.fields[f];
+	}
+	for (integer d = 0; d != NDIM; ++d) {
+		lsum[d] += other.lsum[d];
+	}
+	volume += other.volume;
+	return *this;
+}
+
+void conserved_sums_add(integer step, real time, conserved_sums_t sums) {
+	std::lock_guard<std::mutex> lock(samples_mtx);
+	auto& s = samples[step];
+	s.time = time;
+	s.sums += sums;
+}
+
+HPX_PLAIN_ACTION(conserved_sums_add, conserved_sums_add_action);
+
+void conserved_sums_submit(integer step, real time, integer level, conserved_sums_t sums) {
+	// The volume of a level is a power of two, so the sum over the leaves is exact
+	sums.volume = std::ldexp(1.0, -NDIM * int(level));
+	hpx::apply<conserved_sums_add_action>(hpx::find_root_locality(), step, time, std::move(sums));
+}
+
+void conserved_sums_drain(bool final) {
+	std::vector<std::pair<integer, sample>> complete;
+	{
+		std::lock_guard<std::mutex> lock(samples_mtx);
+		for (auto i = samples.begin(); i != samples.end();) {
+			if (i->second.sums.volume == 1.0) {
+				complete.emplace_back(i->first, std::move(i->second));
+				i = samples.erase(i);
+			} else {
+				++i;
+			}
+		}
+		if (final) {
+			for (const auto& s : samples) {
+				print("Conserved sums of step %i incomplete (%.3f of the domain), dropped\n", int(s.first), double(s.second.sums.volume));
+			}
+			samples.clear();
+		}
+	}
+	for (const auto& c : complete) {
+		const auto& s = c.second.sums;
+		if (!have_reference) {
+			reference = s;
+			have_reference = true;
+		}
+		std::vector<double> row = { double(c.first), double(c.second.time) };
+		row.insert(row.end(), s.fields.begin(), s.fields.end());
+		row.insert(row.end(), s.lsum.begin(), s.lsum.end());
+		telemetry::record(telemetry::conserved_stream, std::move(row));
+		print("Conserved sums at step %i: mass drift %e, energy drift %e\n", int(c.first), double(relative_drift(rho_i, s)),
+				double(relative_drift(egas_i, s)));
+	}
+}
@@ -15,6 +15,7 @@
 #include "octotiger/options.hpp"
 #include "octotiger/problem.hpp"
 #include "octotiger/profiler.hpp"
+#include "octotiger/scratch_pool.hpp"
 #include "octotiger/io/silo.hpp"
 #include "octotiger/taylor.hpp"
 #include "octotiger/unitiger/hydro.hpp"
@@ -22,10 +23,12 @@
 #include "octotiger/unitiger/hydro_impl/reconstruct.hpp"
 #include "octotiger/unitiger/hydro_impl/flux.hpp"
 
+#include <hpx/include/lcos.hpp>
 #include <hpx/include/runtime.hpp>
 #include <hpx/collectives/broadcast_direct.hpp>
 #include <hpx/synchronization/once.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
@@ -374,12 +377,48 @@ void grid::set_idle_rate() {
 
 // MSVC needs this variable to be in the global namespace
 constexpr integer nspec = 2;
+conserved_sums_t grid::conserved_sums() const {
+	conserved_sums_t rc;
+	rc.fields.assign(opts().n_fields, 0.0);
+	const real dV = dx * dx * dx;
+	for (integer j = H_BW; j != H_NX - H_BW; ++j) {
+		for (integer k = H_BW; k != H_NX - H_BW; ++k) {
+			for (integer l = H_BW; l != H_NX - H_BW; ++l) {
+				const integer iii = hindex(j, k, l);
+				for (integer f = 0; f != opts().n_fields; ++f) {
+					rc.fields[f] += U[f][iii] * dV;
+				}
+				rc.fields[egas_i] += 0.5 * U[pot_i][iii] * dV;
+				rc.lsum[0] += U[lx_i][iii] * dV - (X[YDIM][iii] * U[sz_i][iii] - X[ZDIM][iii] * U[sy_i][iii]) * dV;
+				rc.lsum[1] -= U[ly_i][iii] * dV - (X[XDIM][iii] * U[sz_i][iii] - X[ZDIM][iii] * U[sx_i][iii]) * dV;
+				rc.lsum[2] += U[lz_i][iii] * dV - (X[XDIM][iii] * U[sy_i][iii] - X[YDIM][iii] * U[sx_i][iii]) * dV;
+			}
+		}
+	}
+	for (integer f = 0; f != opts().n_fields; ++f) {
+		rc.fields[f] += U_out[f];
+	}
+	rc.fields[egas_i] += U_out[pot_i];
+	return rc;
+}
+
+void grid::snapshot_diagnostics() {
+	PROFILE();
+	diag_U = U;
+	diag_G = G;
+	diag_U_out = U_out;
+}
+
 diagnostics_t grid::diagnostics(const diagnostics_t &diags) {
 	PROFILE();
 	diagnostics_t rc;
 	if (opts().disable_diagnostics) {
 		return rc;
 	}
+	// Work on the snapshot, the grid itself may already be in the next step
+	const auto &U = diag_U;
+	const auto &G = diag_G;
+	const auto &U_out = diag_U_out;
 	const real dV = dx * dx * dx;
 	real x, y, z;
 	integer iii, iiig;
@@ -773,7 +812,7 @@ std::vector<real> grid::get_prolong(const std::array<integer, NDIM> &lb, const s
 	data.reserve(size);
 
 	for (integer f = 0; f < opts().n_fields; f++) {
-		const auto &u = U[f];
+		const auto u = U[f];
 		for (integer i = lb[XDIM]; i != ub[XDIM]; ++i) {
 			const real x = (i % 2) ? +1 : -1;
 			for (integer j = lb[YDIM]; j != ub[YDIM]; ++j) {
@@ -857,7 +896,7 @@ void grid::set_hydro_boundary(const std::vector<real> &data, const geo::directio
 
 	for (integer field = 0; field != opts().n_fields; ++field) {
 		get_boundary_size(lb, ub, dir, OUTER, INX, H_BW, bw[field]);
-		auto &Ufield = U[field];
+		const auto Ufield = U[field];
 		for (integer i = lb[XDIM]; i < ub[XDIM]; ++i) {
 			for (integer j = lb[YDIM]; j < ub[YDIM]; ++j) {
 				for (integer k = lb[ZDIM]; k < ub[ZDIM]; ++k) {
@@ -884,7 +923,7 @@ std::vector<real> grid::get_hydro_boundary(const geo::direction &dir, bool energ
 	integer iter = 0;
 	for (integer field = 0; field != opts().n_fields; ++field) {
 		get_boundary_size(lb, ub, dir, INNER, INX, H_BW, bw[field]);
-		auto &Ufield = U[field];
+		const auto Ufield = U[field];
 		for (integer i = lb[XDIM]; i < ub[XDIM]; ++i) {
 			for (integer j = lb[YDIM]; j < ub[YDIM]; ++j) {
 				for (integer k = lb[ZDIM]; k < ub[ZDIM]; ++k) {
@@ -1537,15 +1576,15 @@ void grid::rho_mult(real f0, real f1) {
 
 void grid::rho_move(real x) {
 	real w = x / dx;
-	U0 = U;
+	const auto U_prev = U;
 
 	w = std::max(-0.5, std::min(0.5, w));
 	for (integer i = 1; i != H_NX - 1; ++i) {
 		for (integer j = 1; j != H_NX - 1; ++j) {
 			for (integer k = 1; k != H_NX - 1; ++k) {
 				for (integer si = spc_i; si != opts().n_species + spc_i; ++si) {
-					U[si][hindex(i, j, k)] += w * U0[si][hindex(i + 1, j, k)];
-					U[si][hindex(i, j, k)] -= w * U0[si][hindex(i - 1, j, k)];
+					U[si][hindex(i, j, k)] += w * U_prev[si][hindex(i + 1, j, k)];
+					U[si][hindex(i, j, k)] -= w * U_prev[si][hindex(i - 1, j, k)];
 					U[si][hindex(i, j, k)] = std::max((double) U[si][hindex(i, j, k)], 0.0);
 				}
 				U[rho_i][hindex(i, j, k)] = 0.0;
@@ -1596,8 +1635,7 @@ space_vector grid::center_of_mass() const {
 }
 
 grid::grid(real _dx, std::array<real, NDIM> _xmin) :
-		is_coarse(H_N3), has_coarse(H_N3), Ushad(opts().n_fields), U(opts().n_fields), U0(opts().n_fields), dUdt(opts().n_fields), F(NDIM), X(NDIM), G(NGF), is_root(
-				false), is_leaf(true) {
+		X(NDIM), G(NGF), is_root(false), is_leaf(true) {
 	dx = _dx;
 	xmin = _xmin;
 	allocate();
@@ -1775,6 +1813,41 @@ analytic_t grid::compute_analytic(real t) {
 	return a;
 }
 
+struct grid::persistent_storage {
+	decltype(grid::U) U;
+	decltype(grid::X) X;
+	decltype(grid::G) G;
+	decltype(grid::L) L;
+	decltype(grid::L_c) L_c;
+};
+
+scratch_pool<grid::persistent_storage> grid::storage_pool;
+
+void grid::release_storage() {
+	// Moved from or never allocated. Grids may be destroyed after the runtime stopped, so this must not
+	// look at opts() or the HPX runtime.
+	if (U.field_size() != H_N3 || X.size() != NDIM || X[0].size() != H_N3 || G.size() != G_N3
+			|| L.size() != G_N3 || L_c.size() != G_N3) {
+		return;
+	}
+	storage_pool.release(persistent_storage { std::move(U), std::move(X), std::move(G), std::move(L), std::move(L_c) });
+}
+
+HPX_PLAIN_ACTION(grid::trim_storage_pool, trim_storage_pool_action);
+
+void grid::trim_storage_pool(std::size_t keep, bool bcast) {
+	std::vector<hpx::future<void>> futs;
+	if (bcast) {
+		for (hpx::id_type const &id : options::all_localities) {
+			if (id != hpx::find_here()) {
+				futs.push_back(hpx::async<trim_storage_pool_action>(id, keep, false));
+			}
+		}
+	}
+	storage_pool.trim(keep);
+	hpx::wait_all(futs);
+}
+
 void grid::allocate() {
 
 	if (opts().radiation) {
@@ -1783,24 +1856,27 @@ void grid::allocate() {
 	}
 	U_out0 = std::vector<real>(opts().n_fields, ZERO);
 	U_out = std::vector<real>(opts().n_fields, ZERO);
-	dphi_dt = std::vector<real>(INX * INX * INX);
-	G.resize(G_N3);
-	for (integer dim = 0; dim != NDIM; ++dim) {
-		X[dim].resize(H_N3);
-	}
-
-	for (integer field = 0; field != opts().n_fields; ++field) {
-		U0[field].resize(INX * INX * INX);
-
-		U[field].resize(H_N3, 0.0);
-		Ushad[field].resize(HS_N3, 1.0);
-		dUdt[field].resize(INX * INX * INX);
+	auto storage = storage_pool.acquire();
+	if (!storage.U.empty()) {
+		// X is set below
+		U = std::move(storage.U);
+		X = std::move(storage.X);
+		G = std::move(storage.G);
+		L = std::move(storage.L);
+		L_c = std::move(storage.L_c);
+		U.fill(safe_real(0.0));
+		std::fill(G.begin(), G.end(), decltype(G)::value_type());
+		std::fill(L.begin(), L.end(), expansion());
+		std::fill(L_c.begin(), L_c.end(), space_vector());
+	} else {
+		G.resize(G_N3);
 		for (integer dim = 0; dim != NDIM; ++dim) {
-			F[dim][field].resize(F_N3);
+			X[dim].resize(H_N3);
 		}
+		U.resize(opts().n_fields, H_N3, 0.0);
+		L.resize(G_N3);
+		L_c.resize(G_N3);
 	}
-	L.resize(G_N3);
-	L_c.resize(G_N3);
 	integer nlevel = 0;
 	com_ptr.resize(2);
 
@@ -1812,15 +1888,124 @@ void grid::allocate() {
 
 }
 
+// Temporaries that are only needed while a leaf advances its hydro state are not part of the
+// persistent per node memory. They are borrowed from these pools for the duration of a time-step
+// (U0), of a single Runge-Kutta stage (dUdt, F, dphi_dt) or of an AMR boundary exchange (Ushad,
+// is_coarse, has_coarse) and returned afterwards.
+namespace {
+struct stage_scratch_type {
+	field_storage<safe_real> dUdt;
+	std::vector<field_storage<safe_real>> F;
+	std::vector<real> dphi_dt;
+};
+
+struct amr_scratch_type {
+	std::vector<std::vector<real>> Ushad;
+	coarse_mask is_coarse;
+	coarse_mask has_coarse;
+};
+
+scratch_pool<field_storage<safe_real>> step_scratch_pool;
+scratch_pool<stage_scratch_type> stage_scratch_pool;
+scratch_pool<amr_scratch_type> amr_scratch_pool;
+}
+
+void grid::acquire_step_scratch() {
+	if (!U0.empty()) {
+		return;
+	}
+	U0 = step_scratch_pool.acquire();
+	if (U0.empty()) {
+		U0.resize(opts().n_fields, INX * INX * INX);
+	}
+}
+
+void grid::release_step_scratch() {
+	if (!U0.empty()) {
+		step_scratch_pool.release(std::move(U0));
+		U0.clear();
+	}
+}
+
+void grid::acquire_stage_scratch() {
+	if (!dUdt.empty()) {
+		return;
+	}
+	auto scratch = stage_scratch_pool.acquire();
+	if (scratch.dUdt.empty()) {
+		scratch.dUdt.resize(opts().n_fields, INX * INX * INX);
+		scratch.F.resize(NDIM);
+		for (integer dim = 0; dim != NDIM; ++dim) {
+			scratch.F[dim].resize(opts().n_fields, F_N3);
+		}
+		scratch.dphi_dt.resize(INX * INX * INX);
+	}
+	// dphi_dt is only computed when gravity is on
+	std::fill(scratch.dphi_dt.begin(), scratch.dphi_dt.end(), 0.0);
+	dUdt = std::move(scratch.dUdt);
+	F = std::move(scratch.F);
+	dphi_dt = std::move(scratch.dphi_dt);
+}
+
+void grid::release_stage_scratch() {
+	if (!dUdt.empty()) {
+		stage_scratch_type scratch;
+		scratch.dUdt = std::move(dUdt);
+		scratch.F = std::move(F);
+		scratch.dphi_dt = std::move(dphi_dt);
+		stage_scratch_pool.release(std::move(scratch));
+		dUdt.clear();
+		F.clear();
+		dphi_dt.clear();
+	}
+}
+
+bool grid::has_amr_scratch() const {
+	return !Ushad.empty();
+}
+
+void grid::acquire_amr_scratch() {
+	if (has_amr_scratch()) {
+		return;
+	}
+	auto scratch = amr_scratch_pool.acquire();
+	if (scratch.Ushad.empty()) {
+		scratch.Ushad.resize(opts().n_fields, std::vector<real>(HS_N3, 1.0));
+		scratch.is_coarse.resize(HS_N3);
+		scratch.has_coarse.resize(HS_N3);
+	} else {
+		// Recycled buffers hold another grid's boundary, reset them to their initial state
+		for (auto &u : scratch.Ushad) {
+			std::fill(u.begin(), u.end(), 1.0);
+		}
+		scratch.is_coarse.clear();
+		scratch.has_coarse.clear();
+	}
+	Ushad = std::move(scratch.Ushad);
+	is_coarse = std::move(scratch.is_coarse);
+	has_coarse = std::move(scratch.has_coarse);
+}
+
+void grid::release_amr_scratch() {
+	if (has_amr_scratch()) {
+		amr_scratch_type scratch;
+		scratch.Ushad = std::move(Ushad);
+		scratch.is_coarse = std::move(is_coarse);
+		scratch.has_coarse = std::move(has_coarse);
+		amr_scratch_pool.release(std::move(scratch));
+		Ushad.clear();
+		is_coarse = coarse_mask();
+		has_coarse = coarse_mask();
+	}
+}
+
 grid::grid() :
-		is_coarse(H_N3), has_coarse(H_N3), Ushad(opts().n_fields), U(opts().n_fields), U0(opts().n_fields), dUdt(opts().n_fields), F(NDIM), X(NDIM), G(NGF), dphi_dt(
-				H_N3), is_root(false), is_leaf(true), U_out(opts().n_fields, ZERO), U_out0(opts().n_fields, ZERO) {
+		X(NDIM), G(NGF), is_root(false), is_leaf(true), U_out(opts().n_fields, ZERO), U_out0(opts().n_fields, ZERO) {
 //	allocate();
 }
 
 grid::grid(const init_func_type &init_func, real _dx, std::array<real, NDIM> _xmin) :
-		is_coarse(H_N3), has_coarse(H_N3), Ushad(opts().n_fields), U(opts().n_fields), U0(opts().n_fields), dUdt(opts().n_fields), F(NDIM), X(NDIM), G(NGF), is_root(
-				false), is_leaf(true), U_out(opts().n_fields, ZERO), U_out0(opts().n_fields, ZERO), dphi_dt(H_N3) {
+		X(NDIM), G(NGF), is_root(false), is_leaf(true), U_out(opts().n_fields, ZERO), U_out0(opts().n_fields, ZERO) {
 
 	dx = _dx;
 	xmin = _xmin;
@@ -1895,7 +2080,7 @@ timestep_t grid::compute_fluxes() {
 //			print("%e %e\n", physcon().A, physcon().B);
 			physics<NDIM>::set_degenerate_eos(physcon().A, physcon().B);
 		} else if (opts().eos == IPR) {
-			physics<NDIM>::set_ideal_plus_rad_eos(physcon().kb / physcon().mh, 4 * physcon().sigma / physcon().c, opts().ipr_nr_tol, opts().ipr_nr_maxiter, opts().ipr_test, opts().ipr_eint_floor);
+			physics<NDIM>::set_ideal_plus_rad_eos(physcon().kb / physcon().mh, 4 * physcon().sigma / physcon().c, opts().ipr_nr_tol, opts().ipr_nr_maxiter, opts().ipr_test, opts().ipr_eint_floor, opts().ipr_table, opts().ipr_table_polish);
 		}
 		physics<NDIM>::set_dual_energy_switches(opts().dual_energy_sw1, opts().dual_energy_sw2);
 	});
@@ -1955,6 +2140,7 @@ void grid::set_max_level(integer l) {
 
 void grid::store() {
 	PROFILE();
+	acquire_step_scratch();
 	for (integer field = 0; field != opts().n_fields; ++field) {
 #pragma GCC ivdep
 		for (integer i = 0; i != INX; ++i) {
@@ -1974,7 +2160,7 @@ void grid::restore() {
 		for (integer i = 0; i != INX; ++i) {
 			for (integer j = 0; j != INX; ++j) {
 				for (integer k = 0; k != INX; ++k) {
-					U[field][h0index(i, j, k)] = U0[field][hindex(i + H_BW, j + H_BW, k + H_BW)];
+					U[field][hindex(i + H_BW, j + H_BW, k + H_BW)] = U0[field][h0index(i, j, k)];
 				}
 			}
 		}
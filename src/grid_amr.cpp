@@ -4,9 +4,13 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include "octotiger/grid.hpp"
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/test_problems/amr/amr.hpp"
 #include "octotiger/unitiger/util.hpp"
 
+#include <cstdio>
+#include <string>
+
 std::vector<real> grid::get_subset(const std::array<integer, NDIM> &lb, const std::array<integer, NDIM> &ub, bool energy_only) {
 	PROFILE();
 	std::vector<real> data;
@@ -26,6 +30,7 @@ std::vector<real> grid::get_subset(const std::array<integer, NDIM> &lb, const st
 
 void grid::set_hydro_amr_boundary(const std::vector<real> &data, const geo::direction &dir, bool energy_only) {
 	PROFILE();
+	acquire_amr_scratch();
 
 	std::array<integer, NDIM> lb, ub;
 	int l = 0;
@@ -33,7 +38,7 @@ void grid::set_hydro_amr_boundary(const std::vector<real> &data, const geo::dire
 	for (int i = lb[0]; i < ub[0]; i++) {
 		for (int j = lb[1]; j < ub[1]; j++) {
 			for (int k = lb[2]; k < ub[2]; k++) {
-				is_coarse[hSindex(i, j, k)]++;
+				is_coarse.mark(hSindex(i, j, k));
 				assert(i < H_BW || i >= HS_NX - H_BW || j < H_BW || j >= HS_NX - H_BW || k < H_BW || k >= HS_NX - H_BW);
 			}
 		}
@@ -44,12 +49,19 @@ void grid::set_hydro_amr_boundary(const std::vector<real> &data, const geo::dire
 		ub[dim] = std::min(ub[dim] + 1, integer(HS_NX));
 	}
 
+	for (int i = lb[0]; i < ub[0]; i++) {
+		for (int j = lb[1]; j < ub[1]; j++) {
+			for (int k = lb[2]; k < ub[2]; k++) {
+				has_coarse.mark(hSindex(i, j, k));
+			}
+		}
+	}
+
 	for (int f = 0; f < opts().n_fields; f++) {
 		if (!energy_only || f == egas_i) {
 			for (int i = lb[0]; i < ub[0]; i++) {
 				for (int j = lb[1]; j < ub[1]; j++) {
 					for (int k = lb[2]; k < ub[2]; k++) {
-						has_coarse[hSindex(i, j, k)]++;
 						Ushad[f][hSindex(i, j, k)] = data[l++];
 					}
 				}
@@ -74,38 +86,39 @@ void grid::complete_hydro_amr_boundary(bool energy_only) {
 		return minmod_theta(a, b, 64./37.);
 	};
 
+	// Only interior shadow cells can be prolonged, the outermost layer merely provides the slopes
+	static thread_local std::vector<int> cells;
+	cells.clear();
+	for (const int iii0 : is_coarse.cells()) {
+		if (is_interior_shadow_cell(iii0)) {
+			cells.push_back(iii0);
+		}
+	}
+
 	for (int f = 0; f < opts().n_fields; f++) {
 		if (!energy_only || f == egas_i) {
-
-			for (int i0 = 1; i0 < HS_NX - 1; i0++) {
-				for (int j0 = 1; j0 < HS_NX - 1; j0++) {
-					for (int k0 = 1; k0 < HS_NX - 1; k0++) {
-						const int iii0 = hSindex(i0, j0, k0);
-						if (is_coarse[iii0]) {
-							for (int ir = 0; ir < 2; ir++) {
-								for (int jr = 0; jr < 2; jr++) {
-									for (int kr = 0; kr < 2; kr++) {
-										const auto is = ir % 2 ? +1 : -1;
-										const auto js = jr % 2 ? +1 : -1;
-										const auto ks = kr % 2 ? +1 : -1;
-										const auto &u0 = Ushad[f][iii0];
-										const auto &uc = Ushad[f];
-										const auto s_x = limiter(uc[iii0 + is * HS_DNX] - u0, u0 - uc[iii0 - is * HS_DNX]);
-										const auto s_y = limiter(uc[iii0 + js * HS_DNY] - u0, u0 - uc[iii0 - js * HS_DNY]);
-										const auto s_z = limiter(uc[iii0 + ks * HS_DNZ] - u0, u0 - uc[iii0 - ks * HS_DNZ]);
-										const auto s_xy = limiter(uc[iii0 + is * HS_DNX + js * HS_DNY] - u0, u0 - uc[iii0 - is * HS_DNX - js * HS_DNY]);
-										const auto s_xz = limiter(uc[iii0 + is * HS_DNX + ks * HS_DNZ] - u0, u0 - uc[iii0 - is * HS_DNX - ks * HS_DNZ]);
-										const auto s_yz = limiter(uc[iii0 + js * HS_DNY + ks * HS_DNZ] - u0, u0 - uc[iii0 - js * HS_DNY - ks * HS_DNZ]);
-										const auto s_xyz = limiter(uc[iii0 + is * HS_DNX + js * HS_DNY + ks * HS_DNZ] - u0,
-												u0 - uc[iii0 - is * HS_DNX - js * HS_DNY - ks * HS_DNZ]);
-										auto &uf = Uf[f][iii0][ir][jr][kr];
-										uf = u0;
-										uf += (9.0 / 64.0) * (s_x + s_y + s_z);
-										uf += (3.0 / 64.0) * (s_xy + s_yz + s_xz);
-										uf += (1.0 / 64.0) * s_xyz;
-									}
-								}
-							}
+			const auto &uc = Ushad[f];
+			for (const int iii0 : cells) {
+				for (int ir = 0; ir < 2; ir++) {
+					for (int jr = 0; jr < 2; jr++) {
+						for (int kr = 0; kr < 2; kr++) {
+							const auto is = ir % 2 ? +1 : -1;
+							const auto js = jr % 2 ? +1 : -1;
+							const auto ks = kr % 2 ? +1 : -1;
+							const auto &u0 = uc[iii0];
+							const auto s_x = limiter(uc[iii0 + is * HS_DNX] - u0, u0 - uc[iii0 - is * HS_DNX]);
+							const auto s_y = limiter(uc[iii0 + js * HS_DNY] - u0, u0 - uc[iii0 - js * HS_DNY]);
+							const auto s_z = limiter(uc[iii0 + ks * HS_DNZ] - u0, u0 - uc[iii0 - ks * HS_DNZ]);
+							const auto s_xy = limiter(uc[iii0 + is * HS_DNX + js * HS_DNY] - u0, u0 - uc[iii0 - is * HS_DNX - js * HS_DNY]);
+							const auto s_xz = limiter(uc[iii0 + is * HS_DNX + ks * HS_DNZ] - u0, u0 - uc[iii0 - is * HS_DNX - ks * HS_DNZ]);
+							const auto s_yz = limiter(uc[iii0 + js * HS_DNY + ks * HS_DNZ] - u0, u0 - uc[iii0 - js * HS_DNY - ks * HS_DNZ]);
+							const auto s_xyz = limiter(uc[iii0 + is * HS_DNX + js * HS_DNY + ks * HS_DNZ] - u0,
+									u0 - uc[iii0 - is * HS_DNX - js * HS_DNY - ks * HS_DNZ]);
+							auto &uf = Uf[f][iii0][ir][jr][kr];
+							uf = u0;
+							uf += (9.0 / 64.0) * (s_x + s_y + s_z);
+							uf += (3.0 / 64.0) * (s_xy + s_yz + s_xz);
+							uf += (1.0 / 64.0) * s_xyz;
 						}
 					}
 				}
@@ -114,90 +127,89 @@ void grid::complete_hydro_amr_boundary(bool energy_only) {
 	}
 
 	if (!energy_only) {
-		for (int i0 = 1; i0 < HS_NX - 1; i0++) {
-			for (int j0 = 1; j0 < HS_NX - 1; j0++) {
-				for (int k0 = 1; k0 < HS_NX - 1; k0++) {
-					const int iii0 = hSindex(i0, j0, k0);
-					if (is_coarse[iii0]) {
-						for (int ir = 0; ir < 2; ir++) {
-							for (int jr = 0; jr < 2; jr++) {
-								for (int kr = 0; kr < 2; kr++) {
-									const auto i1 = 2 * i0 - H_BW + ir;
-									const auto j1 = 2 * j0 - H_BW + jr;
-									const auto k1 = 2 * k0 - H_BW + kr;
-									const auto x = (i1) * dx + xmin[XDIM];
-									const auto y = (j1) * dx + xmin[YDIM];
-									const auto z = (k1) * dx + xmin[ZDIM];
-									Uf[lx_i][iii0][ir][jr][kr] -= y * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sy_i][iii0][ir][jr][kr];
-									Uf[ly_i][iii0][ir][jr][kr] += x * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sx_i][iii0][ir][jr][kr];
-									Uf[lz_i][iii0][ir][jr][kr] -= x * Uf[sy_i][iii0][ir][jr][kr] - y * Uf[sx_i][iii0][ir][jr][kr];
-								}
-							}
-						}
-						double zx = 0, zy = 0, zz = 0, rho = 0;
-						for (int ir = 0; ir < 2; ir++) {
-							for (int jr = 0; jr < 2; jr++) {
-								for (int kr = 0; kr < 2; kr++) {
-									zx += Uf[lx_i][iii0][ir][jr][kr] / 8.0;
-									zy += Uf[ly_i][iii0][ir][jr][kr] / 8.0;
-									zz += Uf[lz_i][iii0][ir][jr][kr] / 8.0;
-									//			rho += Uf[rho_i][iii0][ir][jr][kr] / 8.0;
-								}
-							}
-						}
-						for (int ir = 0; ir < 2; ir++) {
-							for (int jr = 0; jr < 2; jr++) {
-								for (int kr = 0; kr < 2; kr++) {
-									//					const auto factor = Uf[rho_i][iii0][ir][jr][kr] / rho;
-									const auto factor = 1.0;
-									Uf[lx_i][iii0][ir][jr][kr] = zx * factor;
-									Uf[ly_i][iii0][ir][jr][kr] = zy * factor;
-									Uf[lz_i][iii0][ir][jr][kr] = zz * factor;
-								}
-							}
-						}
-						for (int ir = 0; ir < 2; ir++) {
-							for (int jr = 0; jr < 2; jr++) {
-								for (int kr = 0; kr < 2; kr++) {
-									const auto i1 = 2 * i0 - H_BW + ir;
-									const auto j1 = 2 * j0 - H_BW + jr;
-									const auto k1 = 2 * k0 - H_BW + kr;
-									const auto x = (i1) * dx + xmin[XDIM];
-									const auto y = (j1) * dx + xmin[YDIM];
-									const auto z = (k1) * dx + xmin[ZDIM];
-									Uf[lx_i][iii0][ir][jr][kr] += y * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sy_i][iii0][ir][jr][kr];
-									Uf[ly_i][iii0][ir][jr][kr] -= x * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sx_i][iii0][ir][jr][kr];
-									Uf[lz_i][iii0][ir][jr][kr] += x * Uf[sy_i][iii0][ir][jr][kr] - y * Uf[sx_i][iii0][ir][jr][kr];
-								}
-							}
-						}
+		for (const int iii0 : cells) {
+			const int i0 = iii0 / HS_DNX;
+			const int j0 = (iii0 / HS_DNY) % HS_NX;
+			const int k0 = iii0 % HS_NX;
+			for (int ir = 0; ir < 2; ir++) {
+				for (int jr = 0; jr < 2; jr++) {
+					for (int kr = 0; kr < 2; kr++) {
+						const auto i1 = 2 * i0 - H_BW + ir;
+						const auto j1 = 2 * j0 - H_BW + jr;
+						const auto k1 = 2 * k0 - H_BW + kr;
+						const auto x = (i1) * dx + xmin[XDIM];
+						const auto y = (j1) * dx + xmin[YDIM];
+						const auto z = (k1) * dx + xmin[ZDIM];
+						Uf[lx_i][iii0][ir][jr][kr] -= y * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sy_i][iii0][ir][jr][kr];
+						Uf[ly_i][iii0][ir][jr][kr] += x * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sx_i][iii0][ir][jr][kr];
+						Uf[lz_i][iii0][ir][jr][kr] -= x * Uf[sy_i][iii0][ir][jr][kr] - y * Uf[sx_i][iii0][ir][jr][kr];
+					}
+				}
+			}
+			double zx = 0, zy = 0, zz = 0, rho = 0;
+			for (int ir = 0; ir < 2; ir++) {
+				for (int jr = 0; jr < 2; jr++) {
+					for (int kr = 0; kr < 2; kr++) {
+						zx += Uf[lx_i][iii0][ir][jr][kr] / 8.0;
+						zy += Uf[ly_i][iii0][ir][jr][kr] / 8.0;
+						zz += Uf[lz_i][iii0][ir][jr][kr] / 8.0;
+						//			rho += Uf[rho_i][iii0][ir][jr][kr] / 8.0;
+					}
+				}
+			}
+			for (int ir = 0; ir < 2; ir++) {
+				for (int jr = 0; jr < 2; jr++) {
+					for (int kr = 0; kr < 2; kr++) {
+						//					const auto factor = Uf[rho_i][iii0][ir][jr][kr] / rho;
+						const auto factor = 1.0;
+						Uf[lx_i][iii0][ir][jr][kr] = zx * factor;
+						Uf[ly_i][iii0][ir][jr][kr] = zy * factor;
+						Uf[lz_i][iii0][ir][jr][kr] = zz * factor;
+					}
+				}
+			}
+			for (int ir = 0; ir < 2; ir++) {
+				for (int jr = 0; jr < 2; jr++) {
+					for (int kr = 0; kr < 2; kr++) {
+						const auto i1 = 2 * i0 - H_BW + ir;
+						const auto j1 = 2 * j0 - H_BW + jr;
+						const auto k1 = 2 * k0 - H_BW + kr;
+						const auto x = (i1) * dx + xmin[XDIM];
+						const auto y = (j1) * dx + xmin[YDIM];
+						const auto z = (k1) * dx + xmin[ZDIM];
+						Uf[lx_i][iii0][ir][jr][kr] += y * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sy_i][iii0][ir][jr][kr];
+						Uf[ly_i][iii0][ir][jr][kr] -= x * Uf[sz_i][iii0][ir][jr][kr] - z * Uf[sx_i][iii0][ir][jr][kr];
+						Uf[lz_i][iii0][ir][jr][kr] += x * Uf[sy_i][iii0][ir][jr][kr] - y * Uf[sx_i][iii0][ir][jr][kr];
 					}
 				}
 			}
 		}
 	}
+
+	// Child (ir, jr, kr) of the shadow cell (i0, j0, k0) is the fine cell 2 * i0 - H_BW + ir (for
+	// either parity of H_BW); children outside of the fine grid are skipped
 	for (int f = 0; f < opts().n_fields; f++) {
 		if (!energy_only || f == egas_i) {
-			for (int i = 0; i < H_NX; i++) {
-				for (int j = 0; j < H_NX; j++) {
-					for (int k = 0; k < H_NX; k++) {
-						const int i0 = (i + H_BW) / 2;
-						const int j0 = (j + H_BW) / 2;
-						const int k0 = (k + H_BW) / 2;
-						const int iii0 = hSindex(i0, j0, k0);
-						const int iiir = hindex(i, j, k);
-						if (is_coarse[iii0]) {
-							int ir, jr, kr;
-							if HOST_CONSTEXPR (H_BW % 2 == 0) {
-								ir = i % 2;
-								jr = j % 2;
-								kr = k % 2;
-							} else {
-								ir = 1 - (i % 2);
-								jr = 1 - (j % 2);
-								kr = 1 - (k % 2);
+			for (const int iii0 : cells) {
+				const int i0 = iii0 / HS_DNX;
+				const int j0 = (iii0 / HS_DNY) % HS_NX;
+				const int k0 = iii0 % HS_NX;
+				for (int ir = 0; ir < 2; ir++) {
+					const int i = 2 * i0 - H_BW + ir;
+					if (i < 0 || i >= H_NX) {
+						continue;
+					}
+					for (int jr = 0; jr < 2; jr++) {
+						const int j = 2 * j0 - H_BW + jr;
+						if (j < 0 || j >= H_NX) {
+							continue;
+						}
+						for (int kr = 0; kr < 2; kr++) {
+							const int k = 2 * k0 - H_BW + kr;
+							if (k < 0 || k >= H_NX) {
+								continue;
 							}
-							U[f][iiir] = Uf[f][iii0][ir][jr][kr];
+							U[f][hindex(i, j, k)] = Uf[f][iii0][ir][jr][kr];
 						}
 					}
 				}
@@ -207,6 +219,10 @@ void grid::complete_hydro_amr_boundary(bool energy_only) {
 }
 
 std::pair<real, real> grid::amr_error() const {
+	// The coarse cell mask is kept after the boundary exchange for the AMR test only
+	if (!has_amr_scratch()) {
+		return std::make_pair(0.0, 0.0);
+	}
 
 	const auto is_physical = [this](int i, int j, int k) {
 		const integer iii = hindex(i, j, k);
@@ -227,6 +243,8 @@ std::pair<real, real> grid::amr_error() const {
 
 	real sum = 0.0, V = 0.0;
 	const real dV = dx * dx * dx;
+	// Rows for error.txt, written with a single append per grid
+	std::string rows;
 	for (int i = 0; i < H_NX; i++) {
 		for (int j = 0; j < H_NX; j++) {
 			for (int k = 0; k < H_NX; k++) {
@@ -239,24 +257,32 @@ std::pair<real, real> grid::amr_error() const {
 					const int j0 = (j + H_BW) / 2;
 					const int k0 = (k + H_BW) / 2;
 					const int iii0 = hSindex(i0, j0, k0);
-					if (is_coarse[iii0]) {
+					if (is_coarse.test(iii0)) {
 						const double v0 = amr_test_analytic(x, y, z);
 						const double v1 = U[rho_i][iii];
 						sum += std::pow(v0 - v1, 2) * dV;
-						FILE *fp = fopen("error.txt", "at");
-						fprintf(fp, "%e %e %e\n", double(y), double(v0), double(v1));
-						fclose(fp);
+						char row[64];
+						snprintf(row, sizeof(row), "%e %e %e\n", double(y), double(v0), double(v1));
+						rows += row;
 						V += dV;
 					}
 				}
 			}
 		}
 	}
+	if (!rows.empty()) {
+		io::submit([&rows]() {
+			if (FILE *fp = fopen("error.txt", "at")) {
+				fputs(rows.c_str(), fp);
+				fclose(fp);
+			}
+		}).get();
+	}
 	return std::make_pair(sum, V);
 }
 
 void grid::clear_amr() {
 	PROFILE();
-	std::fill(is_coarse.begin(), is_coarse.end(), 0);
-	std::fill(has_coarse.begin(), has_coarse.end(), 0);
+	is_coarse.clear();
+	has_coarse.clear();
 }
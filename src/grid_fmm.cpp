@@ -1625,7 +1625,8 @@ expansion_pass_type grid::compute_expansions(gsolve_type type, const expansion_p
 							}
 						}
 						U[pot_i][iiih] = G[iii][phi_i] * U[rho_i][iiih];
-					} else {
+					} else if (!dphi_dt.empty()) {
+						// Only leaves that are advancing hold dphi_dt (see grid::acquire_stage_scratch)
 						dphi_dt[iii0] = physcon().G * L[iii]();
 					}
 				}
@@ -7,6 +7,7 @@
 #include "octotiger/eos.hpp"
 #include "octotiger/grid.hpp"
 #include "octotiger/grid_scf.hpp"
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/lane_emden.hpp"
 #include "octotiger/node_client.hpp"
 #include "octotiger/node_server.hpp"
@@ -102,62 +103,64 @@ static real contact_fill = 0.1; //  Degree of contact - IGNORED FOR NON-CONTACT
 	}
 
 void read_option_file() {
-	FILE *fp = fopen("scf.init", "rt");
-	if (fp != nullptr) {
-		if (hpx::get_locality_id() == 0)
-			print("SCF option file found\n");
-		const auto cmp = [](char *ptr, const char *str) {
-			return strncmp(ptr, str, strlen(str)) == 0;
-		};
-		const auto read_float = [](char *ptr) {
-			while (*ptr != '\0' && *ptr != '=') {
-				++ptr;
-			}
-			if (*ptr == '=') {
-				++ptr;
-			}
-			return std::stof(ptr);
-		};
-		while (!feof(fp)) {
-			char buffer[1024];
-			if (fgets(buffer, 1023, fp) != nullptr) {
-				char *ptr = buffer;
-				while (isspace(*ptr) && *ptr != '\0') {
+	// Read on the I/O pool, the options are plain globals and are set before get() returns
+	io::submit([]() {
+		FILE *fp = fopen("scf.init", "rt");
+		if (fp != nullptr) {
+			if (hpx::get_locality_id() == 0)
+				print("SCF option file found\n");
+			const auto cmp = [](char *ptr, const char *str) {
+				return strncmp(ptr, str, strlen(str)) == 0;
+			};
+			const auto read_float = [](char *ptr) {
+				while (*ptr != '\0' && *ptr != '=') {
 					++ptr;
 				}
-				if (isspace(*ptr)) {
+				if (*ptr == '=') {
 					++ptr;
 				}
-				//if (false) {
-				//}
-				READ_LINE(equal_struct_eos)
-				READ_LINE(contact_fill)
-				READ_LINE(core_frac1)
-				READ_LINE(core_frac2)
-				READ_LINE(async1)
-				READ_LINE(async2)
-				READ_LINE(fill1)
-				READ_LINE(fill2)
-				READ_LINE(nc1)
-				READ_LINE(nc2)
-				READ_LINE(ne1)
-				READ_LINE(ne2)
-				READ_LINE(mu1)
-				READ_LINE(mu2)
-				READ_LINE(M1)
-				READ_LINE(M2)
-				READ_LINE(a) else if (strlen(ptr)) {
-					if (hpx::get_locality_id() == 0)
-						print("unknown SCF option - %s\n", buffer);
+				return std::stof(ptr);
+			};
+			while (!feof(fp)) {
+				char buffer[1024];
+				if (fgets(buffer, 1023, fp) != nullptr) {
+					char *ptr = buffer;
+					while (isspace(*ptr) && *ptr != '\0') {
+						++ptr;
+					}
+					if (isspace(*ptr)) {
+						++ptr;
+					}
+					//if (false) {
+					//}
+					READ_LINE(equal_struct_eos)
+					READ_LINE(contact_fill)
+					READ_LINE(core_frac1)
+					READ_LINE(core_frac2)
+					READ_LINE(async1)
+					READ_LINE(async2)
+					READ_LINE(fill1)
+					READ_LINE(fill2)
+					READ_LINE(nc1)
+					READ_LINE(nc2)
+					READ_LINE(ne1)
+					READ_LINE(ne2)
+					READ_LINE(mu1)
+					READ_LINE(mu2)
+					READ_LINE(M1)
+					READ_LINE(M2)
+					READ_LINE(a) else if (strlen(ptr)) {
+						if (hpx::get_locality_id() == 0)
+							print("unknown SCF option - %s\n", buffer);
+					}
 				}
 			}
+			fclose(fp);
+		} else {
+			if (hpx::get_locality_id() == 0)
+				print("SCF option file \"scf.init\" not found - using defaults\n");
 		}
-		fclose(fp);
-	} else {
-		if (hpx::get_locality_id() == 0)
-			print("SCF option file \"scf.init\" not found - using defaults\n");
-	}
-
+	}).get();
 }
 
 }
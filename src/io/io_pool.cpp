@@ -0,0 +1,91 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/config/compiler_specific.hpp>
+#if !defined(HPX_COMPUTE_DEVICE_CODE)
+
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/options.hpp"
+
+#include <hpx/include/resource_partitioner.hpp>
+#include <hpx/program_options.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace io {
+
+namespace {
+
+// With --io_threads=-1 (the default) one core is set aside for I/O once there are at least this many
+constexpr std::size_t auto_pool_min_cores = 8;
+
+void create_pool(hpx::resource::partitioner& rp, const hpx::program_options::variables_map&) {
+	// Use the last cores, the default pool keeps the first ones (and with them worker thread 0)
+	std::vector<hpx::resource::pu> pus;
+	for (const auto& numa : rp.numa_domains()) {
+		for (const auto& core : numa.cores()) {
+			if (!core.pus().empty()) {
+				pus.push_back(core.pus().front());
+			}
+		}
+	}
+	int io_threads = opts().io_threads;
+	if (io_threads < 0) {
+		io_threads = pus.size() >= auto_pool_min_cores ? 1 : 0;
+	}
+	if (io_threads == 0) {
+		return;
+	}
+	if (pus.size() < std::size_t(io_threads) + 1) {
+		std::cout << "Not enough cores for " << io_threads << " I/O threads, I/O runs on separate OS threads" << std::endl;
+		return;
+	}
+	rp.create_thread_pool(pool_name, hpx::resource::scheduling_policy::local_priority_fifo);
+	for (std::size_t i = pus.size() - io_threads; i < pus.size(); i++) {
+		rp.add_resource(pus[i], pool_name);
+	}
+}
+
+}
+
+void configure(hpx::init_params& params, int argc, char* argv[]) {
+	// The pool has to exist before hpx_main processes the options, so io_threads is looked up here the
+	// same way (command line first, then the configuration file). The option itself belongs to opts().
+	namespace po = hpx::program_options;
+	po::options_description desc;
+	desc.add_options() //
+	("io_threads", po::value<integer>(&(opts().io_threads))->default_value(-1), "") //
+	("config_file", po::value<std::string>()->default_value(""), "") //
+	;
+	po::variables_map vm;
+	po::store(po::command_line_parser(argc, argv).options(desc).allow_unregistered().run(), vm);
+	const auto config_file = vm["config_file"].as<std::string>();
+	if (!config_file.empty()) {
+		std::ifstream cfg_fs { config_file };
+		if (cfg_fs) {
+			po::store(po::parse_config_file(cfg_fs, desc, true), vm);
+		}
+	}
+	po::notify(vm);
+	params.rp_callback = &create_pool;
+}
+
+hpx::threads::thread_pool_base* pool() {
+	static hpx::threads::thread_pool_base* const p = []() -> hpx::threads::thread_pool_base* {
+		if (!hpx::resource::pool_exists(pool_name)) {
+			return nullptr;
+		}
+		return &hpx::resource::get_thread_pool(pool_name);
+	}();
+	return p;
+}
+
+}
+
+#endif
@@ -1,11 +1,12 @@
 #include <hpx/config/compiler_specific.hpp>
 #if !defined(HPX_COMPUTE_DEVICE_CODE)
 
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/io/silo.hpp"
 #include "octotiger/node_registry.hpp"
+#include "octotiger/telemetry.hpp"
 
 #include <ctime>
-#include <hpx/runtime/threads/run_as_os_thread.hpp>
 #include <cerrno>
 
 #include <sys/stat.h>
@@ -104,8 +105,9 @@ void output_stage1(std::string fname, int cycle) {
 		const auto *node_ptr_ = GET(i->second.get_ptr());
 		if (!node_ptr_->refined()) {
 			futs_.push_back(hpx::async(hpx::launch::async_policy(hpx::threads::thread_priority::boost), [](node_location loc, node_registry::node_ptr ptr) {
-				const auto *this_ptr = ptr.get_ptr().get();
+				auto *this_ptr = ptr.get_ptr().get();
 				assert(this_ptr);
+				timings::scope ts(this_ptr->timings_, timings::time_silo_stages);
 				const real dx = TWO / real(1 << loc.level()) / real(INX);
 				mesh_vars_t rc(loc);
 				const std::string suffix = oct_to_str(loc.to_id());
@@ -168,7 +170,7 @@ void output_stage3(std::string fname, int cycle, int gn, int gb, int ge) {
 	const auto dir = opts().data_dir;
 	std::string this_fname = dir  + fname + ".silo.data/" + std::to_string(gn) + std::string(".silo");
 	double dtime = silo_output_rotation_time();
-	hpx::threads::run_as_os_thread([&this_fname, this_id, &dtime, gb, gn, ge](integer cycle) {
+	io::submit([&this_fname, this_id, &dtime, gb, gn, ge](integer cycle) {
 		DBfile *db;
 		if (this_id == gb) {
 //			print( "Create %s %i %i %i %i\n", this_fname.c_str(), this_id, gn, gb, ge);
@@ -259,7 +261,7 @@ void output_stage4(std::string fname, int cycle) {
 	std::string this_fname = opts().data_dir + "/" + fname + std::string(".silo");
 	double dtime = silo_output_rotation_time();
 	double rtime = silo_output_rotation_time();
-	hpx::threads::run_as_os_thread([&this_fname, fname, nfields, &rtime](int cycle) {
+	io::submit([&this_fname, fname, nfields, &rtime](int cycle) {
 		auto *db = DBCreateReal(this_fname.c_str(), DB_CLOBBER, DB_LOCAL, "Octo-tiger", SILO_DRIVER);
 		double dtime = silo_output_time();
 		float ftime = dtime;
@@ -516,9 +518,11 @@ void output_all(node_server *root_ptr, std::string fname, int cycle, bool block)
 		print("Skipping SILO output\n");
 		return;
 	}
+	// step.dat, binary.dat and sums.dat are complete up to the checkpoint
+	telemetry::flush();
 
 	std::string dir = opts().data_dir + "/" + fname + ".silo.data";
-	hpx::threads::run_as_os_thread([&]() {
+	io::submit([&]() {
 		auto rc = mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 		if (rc != 0 && errno != EEXIST) {
 			print("Could not create directory for SILO file. mkdir failed with error. code: %i name: %s", errno, std::strerror(errno));
@@ -0,0 +1,434 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/kernel_counters.hpp"
+#include "octotiger/defs.hpp"
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/monopole_interactions/util/calculate_stencil.hpp"
+#include "octotiger/multipole_interactions/util/calculate_stencil.hpp"
+
+#include <hpx/include/actions.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/runtime.hpp>
+#include <hpx/include/serialization.hpp>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace kernel_counters {
+
+namespace {
+
+enum hw_event {
+	hw_cycles, hw_instructions, hw_llc_misses, hw_fp_ops, hw_count
+};
+
+// perf_event_open counters of the calling OS thread, opened as one group so that they are read
+// together. Events the CPU or the kernel do not support are left out.
+class perf_group {
+	std::array<int, hw_count> fd;
+	std::array<int, hw_count> slot;
+	int leader = -1;
+	int n = 0;
+
+public:
+	perf_group() {
+		fd.fill(-1);
+		slot.fill(-1);
+#if defined(__linux__)
+		const std::array<std::pair<std::uint32_t, std::uint64_t>, hw_count> events = { {
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+				{ PERF_TYPE_RAW, std::uint64_t(opts().hw_fp_event) } } };
+		for (int e = 0; e < hw_count; e++) {
+			if (e == hw_fp_ops && opts().hw_fp_event == 0) {
+				continue;
+			}
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = events[e].first;
+			attr.config = events[e].second;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP;
+			fd[e] = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+			if (fd[e] >= 0) {
+				if (leader < 0) {
+					leader = fd[e];
+				}
+				slot[e] = n++;
+			} else if (e == hw_cycles) {
+				// Without a leader there is no group
+				return;
+			}
+		}
+#endif
+	}
+
+	~perf_group() {
+#if defined(__linux__)
+		for (const int f : fd) {
+			if (f >= 0) {
+				close(f);
+			}
+		}
+#endif
+	}
+
+	bool available(int e) const {
+		return slot[e] >= 0;
+	}
+
+	/// Current values, unsupported events read as 0
+	void read(std::uint64_t* values) const {
+		std::fill(values, values + hw_count, 0);
+#if defined(__linux__)
+		if (leader < 0) {
+			return;
+		}
+		std::array<std::uint64_t, hw_count + 1> buf;
+		if (::read(leader, buf.data(), sizeof(std::uint64_t) * (n + 1)) <= 0) {
+			return;
+		}
+		for (int e = 0; e < hw_count; e++) {
+			if (slot[e] >= 0) {
+				values[e] = buf[1 + slot[e]];
+			}
+		}
+#endif
+	}
+};
+
+std::uint64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+/// Sum over the threads of one locality, per kernel variant
+struct entry {
+	int kernel;
+	int variant;
+	std::uint64_t calls;
+	double seconds;
+	double flops;
+	double bytes;
+	/// Hardware counts, -1 where the event was not available
+	std::array<double, hw_count> hw;
+
+	template<class Arc>
+	void serialize(Arc& arc, unsigned) {
+		arc & kernel;
+		arc & variant;
+		arc & calls;
+		arc & seconds;
+		arc & flops;
+		arc & bytes;
+		arc & hw;
+	}
+};
+
+// Counters of one OS thread, written only by the owning thread (see profiler_thread_table)
+struct thread_table {
+	struct counters {
+		std::atomic<std::uint64_t> calls;
+		std::atomic<std::uint64_t> ns;
+		std::atomic<double> flops;
+		std::atomic<double> bytes;
+		std::array<std::atomic<std::uint64_t>, hw_count> hw;
+	};
+	std::array<std::array<counters, max_variants>, kernel_count> c;
+	perf_group perf;
+
+	thread_table() {
+		for (auto& k : c) {
+			for (auto& v : k) {
+				v.calls.store(0, std::memory_order_relaxed);
+				v.ns.store(0, std::memory_order_relaxed);
+				v.flops.store(0.0, std::memory_order_relaxed);
+				v.bytes.store(0.0, std::memory_order_relaxed);
+				for (auto& h : v.hw) {
+					h.store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	template<class T>
+	static void add(std::atomic<T>& a, T v) {
+		a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+	}
+};
+
+namespace {
+
+std::mutex tables_mtx;
+std::vector<std::unique_ptr<thread_table>> tables;
+
+thread_local thread_table* this_table = nullptr;
+
+thread_table& this_thread_table() {
+	if (this_table == nullptr) {
+		std::lock_guard<std::mutex> lock(tables_mtx);
+		tables.emplace_back(new thread_table);
+		this_table = tables.back().get();
+	}
+	return *this_table;
+}
+
+double multipole_interactions_per_cell() {
+	static const double n = octotiger::fmm::multipole_interactions::calculate_stencil().stencil_elements.size();
+	return n;
+}
+
+double monopole_interactions_per_cell() {
+	static const double n = octotiger::fmm::monopole_interactions::calculate_stencil().first.size();
+	return n;
+}
+
+constexpr double cells = INX * INX * INX;
+// Components of a multipole (taylor<4>) and of a space vector
+constexpr double multipole_size = 20;
+constexpr double vector_size = NDIM;
+
+}
+
+kernel_cost hydro_cost() {
+	const double nf = opts().n_fields;
+	const double faces = (INX + 1) * (INX + 1) * (INX + 1);
+	return kernel_cost { cells * nf * hydro_flops_per_cell_and_field, sizeof(real)
+			* (nf * H_N3 + NDIM * H_N3 + NDIM * nf * faces) };
+}
+
+kernel_cost amr_cost(std::size_t coarse_cells) {
+	const double nf = opts().n_fields;
+	const double fine = 8.0 * coarse_cells;
+	return kernel_cost { fine * nf * amr_flops_per_fine_cell_and_field, sizeof(real) * nf * (coarse_cells + fine) };
+}
+
+kernel_cost multipole_cost() {
+	// Multipoles and centers of the 27 sub-grids of the stencil in, expansions and angular
+	// momentum corrections out
+	return kernel_cost { cells * multipole_interactions_per_cell() * multipole_flops_per_interaction, sizeof(real)
+			* cells * (27 * (multipole_size + vector_size) + multipole_size + vector_size) };
+}
+
+kernel_cost monopole_cost(bool contains_multipole_neighbor) {
+	double flops = cells * monopole_interactions_per_cell() * monopole_flops_per_interaction;
+	double bytes = sizeof(real) * cells * (27 * (1 + vector_size) + 4);
+	if (contains_multipole_neighbor) {
+		flops += cells * multipole_interactions_per_cell() * p2m_flops_per_interaction;
+		bytes += sizeof(real) * cells * 26 * (multipole_size + vector_size);
+	}
+	return kernel_cost { flops, bytes };
+}
+
+kernel_cost radiation_cost(radiation_variant v) {
+	if (v == radiation_explicit) {
+		// Radiation fields in, face fluxes out
+		return kernel_cost { cells * rad_explicit_flops_per_cell, sizeof(real) * NRF * RAD_N3 * (1 + NDIM) };
+	}
+	// Radiation and coupled hydro fields (egas, tau, sx, sy, sz, rho) updated in place
+	return kernel_cost { cells * rad_implicit_flops_per_cell, sizeof(real) * 2 * cells * (NRF + 6) };
+}
+
+amr_variant amr_kernel_variant(amr_boundary_type t) {
+	if (t == AMR_LEGACY) {
+		return amr_legacy;
+	}
+#ifdef OCTOTIGER_HAVE_CUDA
+	if (t == AMR_CUDA) {
+		return amr_cuda;
+	}
+#endif
+#if defined __x86_64__ && defined OCTOTIGER_HAVE_VC
+	return amr_vc;
+#else
+	return amr_optimized;
+#endif
+}
+
+static_assert(hw_count == 4, "scope keeps one start value per hardware event");
+
+// The HPX thread may be resumed on another OS thread before the kernel returns, the hardware
+// counts of such a call are meaningless and only its time and work are recorded
+void scope::begin() {
+	table_ = &this_thread_table();
+	table_->perf.read(hw_start_);
+	start_ = now();
+}
+
+void scope::end() {
+	const std::uint64_t dt = now() - start_;
+	auto& table = this_thread_table();
+	auto& e = table.c[kernel_][variant_];
+	thread_table::add(e.calls, std::uint64_t(1));
+	thread_table::add(e.ns, dt);
+	thread_table::add(e.flops, cost_.flops);
+	thread_table::add(e.bytes, cost_.bytes);
+	if (&table == table_) {
+		std::uint64_t hw_stop[hw_count];
+		table.perf.read(hw_stop);
+		for (int h = 0; h < hw_count; h++) {
+			thread_table::add(e.hw[h], hw_stop[h] - hw_start_[h]);
+		}
+	}
+}
+
+std::vector<entry> collect() {
+	std::vector<entry> rc;
+	std::lock_guard<std::mutex> lock(tables_mtx);
+	for (int k = 0; k < kernel_count; k++) {
+		for (int v = 0; v < max_variants; v++) {
+			entry r { k, v, 0, 0.0, 0.0, 0.0, { } };
+			r.hw.fill(-1.0);
+			for (const auto& t : tables) {
+				const auto& e = t->c[k][v];
+				r.calls += e.calls.load(std::memory_order_relaxed);
+				r.seconds += e.ns.load(std::memory_order_relaxed) / 1e9;
+				r.flops += e.flops.load(std::memory_order_relaxed);
+				r.bytes += e.bytes.load(std::memory_order_relaxed);
+				for (int h = 0; h < hw_count; h++) {
+					if (t->perf.available(h)) {
+						r.hw[h] = std::max(r.hw[h], 0.0) + e.hw[h].load(std::memory_order_relaxed);
+					}
+				}
+			}
+			if (r.calls > 0) {
+				rc.push_back(r);
+			}
+		}
+	}
+	return rc;
+}
+
+}
+
+HPX_PLAIN_ACTION(kernel_counters::collect, kernel_counters_collect_action);
+
+namespace kernel_counters {
+
+namespace {
+
+const char* kernel_name(int k) {
+	static const char* const names[kernel_count] = { "hydro", "amr_completion", "multipole", "monopole", "radiation" };
+	return names[k];
+}
+
+std::string variant_name(int k, int v) {
+	std::string name;
+	if (k == amr_completion) {
+		static const char* const names[] = { "legacy", "optimized", "vc", "cuda" };
+		name = names[v];
+	} else if (k == radiation) {
+		name = v == radiation_explicit ? "explicit" : "implicit";
+	} else {
+		name = to_string(interaction_host_kernel_type(v));
+	}
+	for (auto& c : name) {
+		c = std::tolower(c);
+	}
+	return name;
+}
+
+}
+
+void report(const std::string& json_file) {
+	std::vector<hpx::future<std::vector<entry>>> futs;
+	futs.reserve(options::all_localities.size());
+	for (const auto& id : options::all_localities) {
+		futs.push_back(hpx::async<kernel_counters_collect_action>(id));
+	}
+	std::map<std::pair<int, int>, entry> merged;
+	for (auto& f : futs) {
+		for (const auto& e : f.get()) {
+			const auto key = std::make_pair(e.kernel, e.variant);
+			auto i = merged.find(key);
+			if (i == merged.end()) {
+				merged.emplace(key, e);
+			} else {
+				auto& m = i->second;
+				m.calls += e.calls;
+				m.seconds += e.seconds;
+				m.flops += e.flops;
+				m.bytes += e.bytes;
+				for (int h = 0; h < hw_count; h++) {
+					if (e.hw[h] >= 0.0) {
+						m.hw[h] = std::max(m.hw[h], 0.0) + e.hw[h];
+					}
+				}
+			}
+		}
+	}
+
+	const double peak_gflops = opts().roofline_peak_gflops;
+	const double peak_gbs = opts().roofline_peak_gbs;
+	print("Kernel roofline (seconds summed over all threads):\n");
+	print("%-16s %-10s %10s %12s %10s %10s %8s %12s %10s\n", "kernel", "variant", "calls", "seconds", "GFLOP/s", "FLOP/byte",
+			"IPC", "LLC miss/call", "% of roof");
+
+	io::submit([&]() {
+		FILE* fp = fopen(json_file.c_str(), "wt");
+		if (fp != nullptr) {
+			fprintf(fp, "{\n  \"peak_gflops\": %e,\n  \"peak_gbs\": %e,\n  \"kernels\": [", peak_gflops, peak_gbs);
+		}
+		bool first = true;
+		for (const auto& i : merged) {
+			const auto& e = i.second;
+			const double gflops = e.seconds > 0.0 ? e.flops / e.seconds * 1e-9 : 0.0;
+			const double intensity = e.bytes > 0.0 ? e.flops / e.bytes : 0.0;
+			const double ipc = e.hw[hw_cycles] > 0.0 ? e.hw[hw_instructions] / e.hw[hw_cycles] : -1.0;
+			// Intensity against the memory traffic the LLC misses actually caused (64 byte lines)
+			const double dram_intensity = e.hw[hw_llc_misses] > 0.0 ? e.flops / (64.0 * e.hw[hw_llc_misses]) : -1.0;
+			double roof = -1.0;
+			if (peak_gflops > 0.0 && peak_gbs > 0.0) {
+				roof = std::min(peak_gflops, intensity * peak_gbs);
+			}
+			print("%-16s %-10s %10llu %12.4e %10.3f %10.3f %8.3f %12.4e %10.2f\n", kernel_name(e.kernel),
+					variant_name(e.kernel, e.variant).c_str(), static_cast<unsigned long long>(e.calls), e.seconds, gflops,
+					intensity, ipc, e.hw[hw_llc_misses] >= 0.0 ? e.hw[hw_llc_misses] / e.calls : -1.0,
+					roof > 0.0 ? 100.0 * gflops / roof : -1.0);
+			if (fp != nullptr) {
+				fprintf(fp,
+						"%s\n    {\"kernel\": \"%s\", \"variant\": \"%s\", \"calls\": %llu, \"seconds\": %.9e, \"flops\": %.9e, "
+								"\"bytes\": %.9e, \"gflops\": %.9e, \"intensity\": %.9e, \"dram_intensity\": %.9e, "
+								"\"cycles\": %.9e, \"instructions\": %.9e, \"llc_misses\": %.9e, \"fp_ops\": %.9e, "
+								"\"ipc\": %.9e, \"attainable_gflops\": %.9e}", first ? "" : ",", kernel_name(e.kernel),
+						variant_name(e.kernel, e.variant).c_str(), static_cast<unsigned long long>(e.calls), e.seconds, e.flops,
+						e.bytes, gflops, intensity, dram_intensity, e.hw[hw_cycles], e.hw[hw_instructions],
+						e.hw[hw_llc_misses], e.hw[hw_fp_ops], ipc, roof);
+			}
+			first = false;
+		}
+		if (fp != nullptr) {
+			fprintf(fp, "\n  ]\n}\n");
+			fclose(fp);
+		} else {
+			print("Unable to open %s for writing\n", json_file.c_str());
+		}
+	}).get();
+}
+
+}
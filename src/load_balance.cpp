@@ -0,0 +1,183 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/load_balance.hpp"
+#include "octotiger/node_registry.hpp"
+#include "octotiger/node_server.hpp"
+#include "octotiger/options.hpp"
+
+#include <hpx/include/actions.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/performance_counters.hpp>
+#include <hpx/include/runtime.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Cumulative share of the space filling curve owned by each locality (size localities + 1), empty
+// for the default equal split by node count
+std::vector<double> partition;
+
+double thread_counter(const std::string& name) {
+	const std::string counter_name = "/threads{locality#" + std::to_string(hpx::get_locality_id()) + "/total}/" + name;
+	try {
+		hpx::performance_counters::performance_counter count(counter_name);
+		return count.get_value<double>(true).get();
+	} catch (...) {
+		// HPX built without this counter
+		return -1.0;
+	}
+}
+
+std::vector<double> current_shares(std::size_t nloc) {
+	std::vector<double> shares(nloc, 1.0 / nloc);
+	if (partition.size() == nloc + 1) {
+		for (std::size_t l = 0; l < nloc; l++) {
+			shares[l] = partition[l + 1] - partition[l];
+		}
+	}
+	return shares;
+}
+
+}
+
+locality_load load_collect() {
+	locality_load load;
+	for (auto i = node_registry::begin(); i != node_registry::end(); ++i) {
+		const node_server* node_ptr_ = GET(i->second.get_ptr());
+		load.nodes++;
+		if (!node_ptr_->refined()) {
+			load.leaves++;
+		}
+		load.amr_boundaries += node_ptr_->amr_boundary_count();
+	}
+	const double busy_ns = thread_counter("time/cumulative");
+	load.busy = busy_ns < 0.0 ? -1.0 : busy_ns / 1e9;
+	// HPX reports the idle rate in units of 0.01%
+	const double idle = thread_counter("idle-rate");
+	load.idle_rate = idle < 0.0 ? -1.0 : idle / 1e4;
+	return load;
+}
+
+HPX_PLAIN_ACTION(load_collect, load_collect_action);
+
+void load_balance_set_partition(std::vector<double> p) {
+	partition = std::move(p);
+}
+
+HPX_PLAIN_ACTION(load_balance_set_partition, load_balance_set_partition_action);
+
+integer load_balance_locality(integer a, integer total) {
+	const integer nloc = options::all_localities.size();
+	if (partition.size() != std::size_t(nloc + 1)) {
+		return a * nloc / total;
+	}
+	const double x = double(a) / double(total);
+	const auto i = std::upper_bound(partition.begin() + 1, partition.end() - 1, x);
+	return integer(i - partition.begin()) - 1;
+}
+
+void load_balance_report(integer step) {
+	std::vector<hpx::future<locality_load>> futs;
+	futs.reserve(options::all_localities.size());
+	for (const auto& id : options::all_localities) {
+		futs.push_back(hpx::async<load_collect_action>(id));
+	}
+	std::vector<locality_load> loads;
+	loads.reserve(futs.size());
+	for (auto& f : futs) {
+		loads.push_back(GET(f));
+	}
+	const std::size_t nloc = loads.size();
+
+	bool have_busy = true;
+	double busy_max = 0.0, busy_sum = 0.0;
+	double nodes_max = 0.0, nodes_sum = 0.0;
+	for (const auto& l : loads) {
+		have_busy = have_busy && l.busy > 0.0;
+		busy_max = std::max(busy_max, l.busy);
+		busy_sum += l.busy;
+		nodes_max = std::max(nodes_max, double(l.nodes));
+		nodes_sum += l.nodes;
+	}
+	// max / mean, 1 is perfectly balanced
+	const double busy_imbalance = have_busy ? busy_max * nloc / busy_sum : -1.0;
+	const double node_imbalance = nodes_sum > 0.0 ? nodes_max * nloc / nodes_sum : -1.0;
+
+	print("Load balance after step %i: busy time imbalance %.3f, node imbalance %.3f\n", int(step), busy_imbalance,
+			node_imbalance);
+	print("   %8s %8s %8s %8s %12s %10s\n", "locality", "nodes", "leaves", "amr_bnd", "busy (s)", "idle rate");
+	for (std::size_t l = 0; l < nloc; l++) {
+		const auto& r = loads[l];
+		print("   %8i %8lli %8lli %8lli %12.4e %10.4f\n", int(l), static_cast<long long>(r.nodes),
+				static_cast<long long>(r.leaves), static_cast<long long>(r.amr_boundaries), r.busy, r.idle_rate);
+	}
+
+	if (!opts().disable_output) {
+		io::submit([&]() {
+			const std::string filename = opts().data_dir + "loadbalance.dat";
+			FILE* fp = fopen(filename.c_str(), "at");
+			if (fp == nullptr) {
+				print("Unable to open %s for writing\n", filename.c_str());
+			} else {
+				if (ftell(fp) == 0) {
+					fprintf(fp, "# step locality nodes leaves amr_boundaries busy idle_rate busy_imbalance node_imbalance\n");
+				}
+				for (std::size_t l = 0; l < nloc; l++) {
+					const auto& r = loads[l];
+					fprintf(fp, "%i %i %lli %lli %lli %e %e %e %e\n", int(step), int(l), static_cast<long long>(r.nodes),
+							static_cast<long long>(r.leaves), static_cast<long long>(r.amr_boundaries), r.busy, r.idle_rate,
+							busy_imbalance, node_imbalance);
+				}
+				fclose(fp);
+			}
+		}).get();
+	}
+
+	if (!opts().load_balance_weighted || nloc < 2) {
+		return;
+	}
+	if (!have_busy) {
+		print("Weighted load balancing needs the HPX busy time counter, keeping the partition\n");
+		return;
+	}
+	if (busy_imbalance < opts().load_imbalance_threshold) {
+		return;
+	}
+	// Give every locality a share of the curve proportional to its measured throughput (nodes per
+	// busy second). Averaging with the current shares damps oscillations between regrids.
+	auto shares = current_shares(nloc);
+	double throughput_sum = 0.0;
+	for (const auto& l : loads) {
+		throughput_sum += l.nodes / l.busy;
+	}
+	std::vector<double> p(nloc + 1, 0.0);
+	for (std::size_t l = 0; l < nloc; l++) {
+		shares[l] = 0.5 * (shares[l] + loads[l].nodes / loads[l].busy / throughput_sum);
+		p[l + 1] = p[l] + shares[l];
+	}
+	for (auto& x : p) {
+		x /= p[nloc];
+	}
+	print("Repartitioning with shares:");
+	for (std::size_t l = 0; l < nloc; l++) {
+		print(" %.3f", p[l + 1] - p[l]);
+	}
+	print("\n");
+
+	std::vector<hpx::future<void>> pfuts;
+	pfuts.reserve(nloc);
+	for (const auto& id : options::all_localities) {
+		pfuts.push_back(hpx::async<load_balance_set_partition_action>(id, p));
+	}
+	for (auto& f : pfuts) {
+		GET(f);
+	}
+}
@@ -4,6 +4,7 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include "mesa.hpp"
+#include "octotiger/io/io_pool.hpp"
 
 #include <cstdio>
 #include <cmath>
@@ -116,35 +117,38 @@ public:
 
 std::function<double(double)> build_rho_of_h_from_mesa(
 		const std::string& filename) {
-	char line[BUFFER_SIZE];
-	char dummy[BUFFER_SIZE];
-	char log10_P[BUFFER_SIZE];
-	char log10_R[BUFFER_SIZE];
-	char log10_rho[BUFFER_SIZE];
-	char vrot_kms[BUFFER_SIZE];
-	FILE* fp = fopen(filename.c_str(), "rt");
-	if (fp == NULL) {
-		print("%s not found!\n", filename.c_str());
-		abort();
-	}
 	std::vector<double> P, rho, h;
-	int linenum = 1;
-	while (fgets(line, sizeof line, fp) != NULL) {
-		if (linenum > HEADER_LINES) {
-			std::sscanf(line,
-					"%s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s\n",
-					dummy, dummy, log10_R, dummy, log10_rho, log10_P, dummy,
-					dummy, dummy, dummy, dummy, dummy, vrot_kms, dummy, dummy,
-					dummy, dummy, dummy, dummy, dummy, dummy, dummy, dummy);
-			P.push_back(std::pow(10, std::atof(log10_P)));
-//			const double tmp = std::pow(10, std::atof(log10_R)) * 6.957e+10;
-//			r.push_back(tmp);
-			rho.push_back(std::pow(10, std::atof(log10_rho)));
-//			omega.push_back(std::atof(vrot_kms) * 100 * 1000 / tmp);
+	// Read on the I/O pool, the buffers are on the heap as they exceed the stack of an HPX thread
+	io::submit([&]() {
+		std::vector<char> line(BUFFER_SIZE);
+		std::vector<char> dummy(BUFFER_SIZE);
+		std::vector<char> log10_P(BUFFER_SIZE);
+		std::vector<char> log10_R(BUFFER_SIZE);
+		std::vector<char> log10_rho(BUFFER_SIZE);
+		std::vector<char> vrot_kms(BUFFER_SIZE);
+		FILE* fp = fopen(filename.c_str(), "rt");
+		if (fp == NULL) {
+			print("%s not found!\n", filename.c_str());
+			abort();
 		}
-		linenum++;
-	}
-	fclose(fp);
+		int linenum = 1;
+		while (fgets(line.data(), int(line.size()), fp) != NULL) {
+			if (linenum > HEADER_LINES) {
+				std::sscanf(line.data(),
+						"%s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s\n",
+						dummy.data(), dummy.data(), log10_R.data(), dummy.data(), log10_rho.data(), log10_P.data(), dummy.data(),
+						dummy.data(), dummy.data(), dummy.data(), dummy.data(), dummy.data(), vrot_kms.data(), dummy.data(), dummy.data(),
+						dummy.data(), dummy.data(), dummy.data(), dummy.data(), dummy.data(), dummy.data(), dummy.data(), dummy.data());
+				P.push_back(std::pow(10, std::atof(log10_P.data())));
+//				const double tmp = std::pow(10, std::atof(log10_R.data())) * 6.957e+10;
+//				r.push_back(tmp);
+				rho.push_back(std::pow(10, std::atof(log10_rho.data())));
+//				omega.push_back(std::atof(vrot_kms.data()) * 100 * 1000 / tmp);
+			}
+			linenum++;
+		}
+		fclose(fp);
+	}).get();
 
 	h.resize(rho.size());
 	double rho_max = rho[rho.size() - 1];
@@ -10,6 +10,7 @@
 #include "octotiger/options.hpp"
 
 #include "octotiger/common_kernel/interactions_iterators.hpp"
+#include "octotiger/kernel_counters.hpp"
 #include "octotiger/monopole_interactions/legacy/monopole_interaction_interface.hpp"
 #include "octotiger/monopole_interactions/util/calculate_stencil.hpp"
 #include "octotiger/options.hpp"
@@ -120,6 +121,9 @@ namespace fmm {
             }    // Nothing is available or device execution is disabled - fallback to host
                  // execution
 
+            kernel_counters::scope kc(kernel_counters::monopole, host_type, [&]() {
+                return kernel_counters::monopole_cost(contains_multipole_neighbor);
+            });
             if (host_type == interaction_host_kernel_type::KOKKOS) {
 #ifdef OCTOTIGER_HAVE_KOKKOS
                 host_executor executor(hpx::kokkos::execution_space_mode::independent);
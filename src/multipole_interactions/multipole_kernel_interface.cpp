@@ -9,6 +9,7 @@
 #include "octotiger/options.hpp"
 
 #include "octotiger/common_kernel/interactions_iterators.hpp"
+#include "octotiger/kernel_counters.hpp"
 #include "octotiger/multipole_interactions/legacy/multipole_interaction_interface.hpp"
 #include "octotiger/multipole_interactions/util/calculate_stencil.hpp"
 #include "octotiger/options.hpp"
@@ -117,6 +118,8 @@ namespace fmm {
             }    // Nothing is available or device execution is disabled - fallback to host
                  // execution
 
+            kernel_counters::scope kc(
+                kernel_counters::multipole, host_type, kernel_counters::multipole_cost);
             if (host_type == interaction_host_kernel_type::KOKKOS) {
 #ifdef OCTOTIGER_HAVE_KOKKOS
                 host_executor executor(hpx::kokkos::execution_space_mode::independent);
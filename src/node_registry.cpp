@@ -6,6 +6,9 @@
 #include "octotiger/node_registry.hpp"
 #include "octotiger/options.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <mutex>
 #include <vector>
@@ -14,13 +17,48 @@ static const auto& localities = options::all_localities;
 
 namespace node_registry {
 
-static table_type table_;
-static hpx::lcos::local::spinlock mtx_;
+namespace {
+
+struct alignas(64) shard {
+	hpx::lcos::local::spinlock mtx;
+	table_type table;
+};
+
+std::array<shard, shard_count> shards_;
+std::atomic<std::size_t> count_(0);
+
+shard& shard_of(const node_location& loc) {
+	// The low bits of the Morton id belong to the coarsest level, the top bits of the product
+	// depend on all of them
+	return shards_[(std::uint64_t(loc.hash()) * 0x9E3779B97F4A7C15ull) >> (64 - shard_bits)];
+}
+
+}
+
+iterator_type::iterator_type(std::size_t shard, table_type::iterator i) :
+		shard_(shard), i_(i) {
+	skip_empty();
+}
+
+void iterator_type::skip_empty() {
+	while (shard_ != shard_count && i_ == shards_[shard_].table.end()) {
+		if (++shard_ != shard_count) {
+			i_ = shards_[shard_].table.begin();
+		}
+	}
+}
+
+iterator_type& iterator_type::operator++() {
+	++i_;
+	skip_empty();
+	return *this;
+}
 
 node_ptr get(const node_location& loc) {
-	std::lock_guard<hpx::lcos::local::spinlock> lock(mtx_);
-	const auto i = table_.find(loc);
-	if (i == table_.end()) {
+	auto& s = shard_of(loc);
+	std::lock_guard<hpx::lcos::local::spinlock> lock(s.mtx);
+	const auto i = s.table.find(loc);
+	if (i == s.table.end()) {
 		print("Error in node_registry::get %s\n", loc.to_str().c_str());
 		abort();
 	}
@@ -28,27 +66,31 @@ node_ptr get(const node_location& loc) {
 }
 
 void add(const node_location& loc, node_ptr id) {
-	std::lock_guard<hpx::lcos::local::spinlock> lock(mtx_);
-	table_[loc] = id;
+	auto& s = shard_of(loc);
+	std::lock_guard<hpx::lcos::local::spinlock> lock(s.mtx);
+	if (s.table.insert_or_assign(loc, std::move(id)).second) {
+		count_++;
+	}
 }
 
 void delete_(const node_location& loc) {
-	std::lock_guard<hpx::lcos::local::spinlock> lock(mtx_);
-	if (table_.find(loc) != table_.end()) {
-		table_.erase(loc);
+	auto& s = shard_of(loc);
+	std::lock_guard<hpx::lcos::local::spinlock> lock(s.mtx);
+	if (s.table.erase(loc)) {
+		count_--;
 	}
 }
 
 iterator_type begin() {
-	return table_.begin();
+	return iterator_type(0, shards_[0].table.begin());
 }
 
 iterator_type end() {
-	return table_.end();
+	return iterator_type(shard_count, table_type::iterator());
 }
 
 const size_t size() {
-  return table_.size();
+	return count_.load();
 }
 
 void clear_();
@@ -58,16 +100,29 @@ void clear_();
 HPX_PLAIN_ACTION(node_registry::clear_, node_registry_clear_action);
 
 namespace node_registry {
+
+namespace {
+
+void clear_local() {
+	for (auto& s : shards_) {
+		std::lock_guard<hpx::lcos::local::spinlock> lock(s.mtx);
+		count_ -= s.table.size();
+		s.table.clear();
+	}
+}
+
+}
+
 void clear_() {
 	std::vector<hpx::future<void>> futs;
 	if (hpx::get_locality_id() == 0) {
 		for (int i = 1; i < localities.size(); i++) {
 			futs.push_back(hpx::async<node_registry_clear_action>(localities[i]));
 		}
-		table_.clear();
+		clear_local();
 		hpx::wait_all(std::move(futs));
 	} else {
-		table_.clear();
+		clear_local();
 	}
 }
 
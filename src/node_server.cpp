@@ -3,6 +3,7 @@
 //  Distributed under the Boost Software License, Version 1.0. (See accompanying
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#include "octotiger/comm_counters.hpp"
 #include "octotiger/defs.hpp"
 #include "octotiger/future.hpp"
 #include "octotiger/node_registry.hpp"
@@ -10,8 +11,10 @@
 #include "octotiger/options.hpp"
 #include "octotiger/problem.hpp"
 #include "octotiger/taylor.hpp"
+#include "octotiger/tracer.hpp"
 #include "octotiger/util.hpp"
 #include "octotiger/interaction_types.hpp"
+#include "octotiger/kernel_counters.hpp"
 
 #include "octotiger/monopole_interactions/monopole_kernel_interface.hpp"
 #include "octotiger/multipole_interactions/multipole_kernel_interface.hpp"
@@ -67,6 +70,19 @@ void node_server::register_counters() {
 	hpx::performance_counters::install_counter_type("/octotiger/subgrids", &cumulative_nodes_count, "total number of subgrids processed");
 	hpx::performance_counters::install_counter_type("/octotiger/subgrid_leaves", &cumulative_leafs_count, "total number of subgrid leaves processed");
 	hpx::performance_counters::install_counter_type("/octotiger/amr_bounds", &cumulative_amrs_count, "total number of amr bounds processed");
+	comm_counters::register_counters();
+}
+
+integer node_server::amr_boundary_count() const {
+	integer count = 0;
+	for (const auto &flags : amr_flags) {
+		for (auto &dir : geo::direction::full_set()) {
+			if (dir.is_face() && flags[dir]) {
+				count++;
+			}
+		}
+	}
+	return count;
 }
 
 real node_server::get_rotation_count() const {
@@ -107,7 +123,7 @@ future<void> node_server::exchange_flux_corrections() {
 		if (this->nieces[f] == +1) {
 			for (auto const &quadrant : geo::quadrant::full_set()) {
 				futs[index++] = niece_hydro_channels[f][quadrant].get_future().then(
-				hpx::util::annotated_function([this, f, quadrant](future<std::vector<real> > &&fdata) -> void {
+				traced_function([this, f, quadrant](future<std::vector<real> > &&fdata) -> void {
 					const auto face_dim = f.get_dimension();
 					std::array<integer, NDIM> lb, ub;
 					switch (face_dim) {
@@ -137,17 +153,17 @@ future<void> node_server::exchange_flux_corrections() {
 						break;
 					}
 					grid_ptr->set_flux_restrict(GET(fdata), lb, ub, face_dim);
-				}, "node_server::exchange_flux_corrections::set_flux_restrict"));
+				}, "node_server::exchange_flux_corrections::set_flux_restrict", my_location));
 			}
 		}
 	}
 	return hpx::when_all(std::move(futs)).then(
-        hpx::util::annotated_function([](future<decltype(futs)> fout) {
+        traced_function([](future<decltype(futs)> fout) {
 		auto fin = GET(fout);
 		for (auto &f : fin) {
 			GET(f);
 		}
-	}, "node_server::exchange_flux_corrections::sync"));
+	}, "node_server::exchange_flux_corrections::sync", my_location));
 }
 
 void node_server::all_hydro_bounds() {
@@ -165,7 +181,7 @@ void node_server::energy_hydro_bounds() {
 }
 
 void node_server::exchange_interlevel_hydro_data() {
-  hpx::util::annotated_function([&]() {
+  traced_function([&]() {
     if (is_refined) {
       std::vector<real> outflow(opts().n_fields, ZERO);
       for (auto const &ci : geo::octant::full_set()) {
@@ -184,11 +200,11 @@ void node_server::exchange_interlevel_hydro_data() {
     if (my_location.level() != 0) {
       parent.send_hydro_children(std::move(data), ci, hcycle);
     }
-  }, "all_hydro_bounds::exchange_interlevel_hydro_data")();
+  }, "all_hydro_bounds::exchange_interlevel_hydro_data", my_location)();
 }
 
 void node_server::collect_hydro_boundaries(bool energy_only) {
-  hpx::util::annotated_function([&]() {
+  traced_function([&]() {
 	grid_ptr->clear_amr();
   const bool use_local_optimization = opts().optimize_local_communication;
   const bool use_local_amr_optimization = opts().optimize_local_communication;
@@ -232,6 +248,8 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
       hpx::future<std::shared_ptr<node_server>> pf = hpx::get_ptr<node_server>(neighbors[dir].get_gid());
       auto direct_access = pf.get();
       const auto &uneighbor = direct_access->grid_ptr->U;
+      // Direct copies from local neighbors pack and unpack in one go
+      timings::scope ts(timings_, timings::time_halo_unpack);
 
       std::array<integer, NDIM> lb_orig, ub_orig;
       std::array<integer, NDIM> lb_target, ub_target;
@@ -275,9 +293,12 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
       hpx::future<std::shared_ptr<node_server>> pf = hpx::get_ptr<node_server>(parent.get_gid());
       auto direct_access = pf.get();
       const auto &uneighbor = direct_access->grid_ptr->U;
+      // Direct copies from local neighbors pack and unpack in one go
+      timings::scope ts(timings_, timings::time_halo_unpack);
       std::array<integer, NDIM> lb_orig, ub_orig;
       std::array<integer, NDIM> lb_target, ub_target;
       get_boundary_size(lb_target, ub_target, dir, OUTER, INX / 2, H_BW);
+      grid_ptr->acquire_amr_scratch();
       // Set is_coarse 
       for (integer i = 0; i < ub_target[XDIM] - lb_target[XDIM]; ++i) {
         const int i_target = i + lb_target[XDIM];
@@ -285,7 +306,7 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
           const int j_target = j + lb_target[YDIM];
           for (integer k = 0; k < ub_target[ZDIM] - lb_target[ZDIM]; ++k) {
             const int k_target = k + lb_target[ZDIM];
-            grid_ptr->is_coarse[hSindex(i_target, j_target, k_target)]++;
+            grid_ptr->is_coarse.mark(hSindex(i_target, j_target, k_target));
             assert(i_target < H_BW || i_target >= HS_NX - H_BW || j_target <
                 H_BW || j_target >= HS_NX - H_BW || k_target < H_BW ||
                 k_target >= HS_NX - H_BW);
@@ -335,7 +356,11 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
         }
       }
     } else if (!neighbors[dir].empty()) {
-        auto bdata = grid_ptr->get_hydro_boundary(dir, energy_only);
+        std::vector<real> bdata;
+        {
+          timings::scope ts(timings_, timings::time_halo_pack);
+          bdata = grid_ptr->get_hydro_boundary(dir, energy_only);
+        }
         neighbors[dir].send_hydro_boundary(std::move(bdata), dir.flip(), hcycle);
     }
 	}
@@ -353,15 +378,16 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
     if (!is_local || (neighbors[dir].empty() && !use_local_amr_optimization) ||
         (!neighbors[dir].empty() && !use_local_optimization)) {
       results[index++] = sibling_hydro_channels[dir].get_future(hcycle).then( // 3s?
-      hpx::util::annotated_function([this, energy_only, dir](future<sibling_hydro_type> &&f) -> void {
+      traced_function([this, energy_only, dir](future<sibling_hydro_type> &&f) -> void {
         auto &&tmp = GET(f);
+        timings::scope ts(timings_, timings::time_halo_unpack);
         if (!neighbors[dir].empty()) {
           grid_ptr->set_hydro_boundary(tmp.data, tmp.direction, energy_only); // 1.5s
         } else {
           grid_ptr->set_hydro_amr_boundary(tmp.data, tmp.direction, energy_only); // 1.5s
 
         }
-      }, "node_server::collect_hydro_boundaries::set_hydro_boundary"));
+      }, "node_server::collect_hydro_boundaries::set_hydro_boundary", my_location));
       // sync
       results[index - 1].get();
     }
@@ -376,7 +402,13 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
 	/* } */
 
 	amr_boundary_type kernel_type = opts().amr_boundary_kernel_type;
-  hpx::util::annotated_function([&]() {
+  // Only grids with a coarser neighbor borrowed the AMR scratch buffers above
+  if (grid_ptr->has_amr_scratch()) {
+  traced_function([&]() {
+	timings::scope ts(timings_, timings::time_amr_completion);
+	kernel_counters::scope kc(kernel_counters::amr_completion, kernel_counters::amr_kernel_variant(kernel_type), [this]() {
+		return kernel_counters::amr_cost(grid_ptr->is_coarse.cells().size());
+	});
 	if (kernel_type == AMR_LEGACY) {
 		grid_ptr->complete_hydro_amr_boundary(energy_only);
 	} else {
@@ -410,17 +442,22 @@ void node_server::collect_hydro_boundaries(bool energy_only) {
 	#endif
 #endif
 	}
-  }, "collect_hydro_boundaries::complete_hydro_amr_boundary")();
+  }, "collect_hydro_boundaries::complete_hydro_amr_boundary", my_location)();
+	// The AMR test reads the coarse cell mask afterwards in amr_error()
+	if (opts().problem != AMR_TEST) {
+		grid_ptr->release_amr_scratch();
+	}
+  }
 	for (auto &face : geo::face::full_set()) {
 		if (my_location.is_physical_boundary(face)) {
 			grid_ptr->set_physical_boundaries(face, current_time);
 		}
 	}
-  }, "all_hydro_bounds::collect_hydro_boundaries")();
+  }, "all_hydro_bounds::collect_hydro_boundaries", my_location)();
 }
 
 void node_server::send_hydro_amr_boundaries(bool energy_only) {
-  hpx::util::annotated_function([&]() {
+  traced_function([&]() {
     if (is_refined) {
       // set promise 
       const bool use_local_optimization = opts().optimize_local_communication;
@@ -448,7 +485,7 @@ void node_server::send_hydro_amr_boundaries(bool energy_only) {
         }
       }
     }
-  }, "all_hydro_bounds::send_hydro_amr_boundaries")();
+  }, "all_hydro_bounds::send_hydro_amr_boundaries", my_location)();
 }
 
 template<class T>
@@ -496,13 +533,17 @@ void node_server::static_initialize() {
 	}
 }
 
-void node_server::initialize(real t, real rt) {
+void node_server::initialize(real t, real rt, bool new_grid) {
 	for (auto const &dir : geo::direction::full_set()) {
 		neighbor_signals[dir].signal();
 	}
 	gcycle = hcycle = rcycle = 0;
 	step_num = 0;
 	refinement_flag = 0;
+	refined_at_step = 0;
+	refinement_held = false;
+	hydro_bounds_current = false;
+	gravity_stale = gravity_stale_energy = false;
 	static_initialize();
 	is_refined = false;
 	neighbors.resize(geo::direction::count());
@@ -513,18 +554,20 @@ void node_server::initialize(real t, real rt) {
 	for (auto &d : geo::dimension::full_set()) {
 		xmin[d] = grid::get_scaling_factor() * my_location.x_location(d);
 	}
-	if (current_time == ZERO && opts().restart_filename=="") {
-		const auto p = get_problem();
-		grid_ptr = std::make_shared<grid>(p, dx, xmin);
-	} else {
-		grid_ptr = std::make_shared<grid>(dx, xmin);
-	}
-	if (opts().radiation) {
-		rad_grid_ptr = grid_ptr->get_rad_grid();
-		rad_grid_ptr->set_dx(dx);
-	}
-	if (my_location.level() == 0) {
-		grid_ptr->set_root();
+	if (new_grid) {
+		if (current_time == ZERO && opts().restart_filename=="") {
+			const auto p = get_problem();
+			grid_ptr = std::make_shared<grid>(p, dx, xmin);
+		} else {
+			grid_ptr = std::make_shared<grid>(dx, xmin);
+		}
+		if (opts().radiation) {
+			rad_grid_ptr = grid_ptr->get_rad_grid();
+			rad_grid_ptr->set_dx(dx);
+		}
+		if (my_location.level() == 0) {
+			grid_ptr->set_root();
+		}
 	}
 	aunts.resize(NFACE);
 
@@ -564,10 +607,12 @@ node_server::node_server(const node_location &loc, const node_client &parent_id,
 
 node_server::node_server(const node_location &_my_location, integer _step_num, bool _is_refined, real _current_time, real _rotational_time,
 		const std::array<integer, NCHILD> &_child_d, grid _grid, const std::vector<hpx::id_type> &_c, std::size_t _hcycle, std::size_t _rcycle,
-		std::size_t _gcycle, integer position_) {
+		std::size_t _gcycle, integer position_, integer refined_at) {
 	my_location = _my_location;
-	initialize(_current_time, _rotational_time);
+	// The grid moves with the node, building and initializing a new one would be wasted
+	initialize(_current_time, _rotational_time, false);
 	position = position_;
+	refined_at_step = refined_at;
 	hcycle = _hcycle;
 	gcycle = _gcycle;
 	rcycle = _rcycle;
@@ -577,6 +622,9 @@ node_server::node_server(const node_location &_my_location, integer _step_num, b
 	rotational_time = _rotational_time;
 //     grid test;
 	grid_ptr = std::make_shared<grid>(std::move(_grid));
+	if (opts().radiation) {
+		rad_grid_ptr = grid_ptr->get_rad_grid();
+	}
 	if (is_refined) {
 		std::copy(_c.begin(), _c.end(), children.begin());
 	}
@@ -608,7 +656,7 @@ void node_server::compute_fmm(gsolve_type type, bool energy_account, bool aonly)
 		for (auto &ci : geo::octant::full_set()) {
 			future<multipole_pass_type> m_in_future = child_gravity_channels[ci].get_future();
 
-			futs[index++] = m_in_future.then(hpx::util::annotated_function([&m_out, ci](future<multipole_pass_type> &&fut) {
+			futs[index++] = m_in_future.then(traced_function([&m_out, ci](future<multipole_pass_type> &&fut) {
 				const integer x0 = ci.get_side(XDIM) * INX / 2;
 				const integer y0 = ci.get_side(YDIM) * INX / 2;
 				const integer z0 = ci.get_side(ZDIM) * INX / 2;
@@ -623,11 +671,13 @@ void node_server::compute_fmm(gsolve_type type, bool energy_account, bool aonly)
 						}
 					}
 				}
-			}, "node_server::compute_fmm::gather_from::child_gravity_channels"));
+			}, "node_server::compute_fmm::gather_from::child_gravity_channels", my_location));
 		}
 		wait_all_and_propagate_exceptions(std::move(futs));
+		timings::scope ts(timings_, timings::time_m2m);
 		m_out = grid_ptr->compute_multipoles(type, &m_out);
 	} else {
+		timings::scope ts(timings_, timings::time_m2m);
 		m_out = grid_ptr->compute_multipoles(type);
 	}
 
@@ -699,10 +749,12 @@ void node_server::compute_fmm(gsolve_type type, bool energy_account, bool aonly)
 		grid_ptr->get_X()[0][hindex(H_BW, H_BW, H_BW)],
 		grid_ptr->get_X()[1][hindex(H_BW, H_BW, H_BW)],
 		grid_ptr->get_X()[2][hindex(H_BW, H_BW, H_BW)] };
+		timings::scope ts(timings_, timings::time_multipole_kernel);
 		octotiger::fmm::multipole_interactions::multipole_kernel_interface(mon_ptr, M_ptr, com_ptr,
 		all_neighbor_interaction_data, type, grid_ptr->get_dx(),
 		is_direction_empty, Xbase, grid_ptr, grid_ptr->get_root());
 	} else { // ... we are a monopole
+		timings::scope ts(timings_, timings::time_monopole_kernel);
 		octotiger::fmm::monopole_interactions::monopole_kernel_interface(mon_ptr, com_ptr, all_neighbor_interaction_data, type,
 		grid_ptr->get_dx(), is_direction_empty, grid_ptr, contains_multipole);
 	}
@@ -736,7 +788,11 @@ void node_server::compute_fmm(gsolve_type type, bool energy_account, bool aonly)
 	if (my_location.level() != 0) {
 		l_in = parent_gravity_channel.get_future().get();
 	}
-	const expansion_pass_type ltmp = grid_ptr->compute_expansions(type, my_location.level() == 0 ? nullptr : &l_in);
+	expansion_pass_type ltmp;
+	{
+		timings::scope ts(timings_, timings::time_l2l);
+		ltmp = grid_ptr->compute_expansions(type, my_location.level() == 0 ? nullptr : &l_in);
+	}
 
 	if (is_refined) {
 		for (auto const &ci : geo::octant::full_set()) {
@@ -770,6 +826,74 @@ void node_server::compute_fmm(gsolve_type type, bool energy_account, bool aonly)
 	++gcycle;
 }
 
+timings_reduction timings_collect() {
+	timings_reduction r;
+	for (auto i = node_registry::begin(); i != node_registry::end(); ++i) {
+		const node_server *node_ptr_ = GET(i->second.get_ptr());
+		r.add_node(node_ptr_->timings_);
+	}
+	return r;
+}
+
+HPX_PLAIN_ACTION(timings_collect, timings_collect_action);
+
+void timings_reset() {
+	for (auto i = node_registry::begin(); i != node_registry::end(); ++i) {
+		node_server *node_ptr_ = GET(i->second.get_ptr());
+		node_ptr_->timings_ = timings();
+	}
+}
+
+HPX_PLAIN_ACTION(timings_reset, timings_reset_action);
+
+std::vector<timings_reduction> timings_collect_all() {
+	std::vector<hpx::future<timings_reduction>> futs;
+	futs.reserve(options::all_localities.size());
+	for (const auto &id : options::all_localities) {
+		futs.push_back(hpx::async<timings_collect_action>(id));
+	}
+	std::vector<timings_reduction> rc;
+	rc.reserve(futs.size());
+	for (auto &f : futs) {
+		rc.push_back(GET(f));
+	}
+	return rc;
+}
+
+void timings_reset_all() {
+	std::vector<hpx::future<void>> futs;
+	futs.reserve(options::all_localities.size());
+	for (const auto &id : options::all_localities) {
+		futs.push_back(hpx::async<timings_reset_action>(id));
+	}
+	for (auto &f : futs) {
+		GET(f);
+	}
+}
+
+void timings_report_phases() {
+	const auto reductions = timings_collect_all();
+	std::cout << "Per node phase timings (min / max / mean seconds):" << std::endl;
+	for (std::size_t l = 0; l < reductions.size(); l++) {
+		const auto &r = reductions[l];
+		print("   locality %i, %i nodes\n", int(l), int(r.nodes_));
+		if (r.nodes_ == 0) {
+			continue;
+		}
+		for (std::size_t t = timings::time_reconstruct_flux; t < timings::time_last; ++t) {
+			print("   %20s %12.4f %12.4f %12.4f\n", timings::name(t), r.min_.get(t), r.max_.get(t),
+					r.sum_.get(t) / r.nodes_);
+		}
+	}
+}
+
 void node_server::report_timing() {
 	timings_.report("...");
+	timings_report_phases();
+#ifndef PROFILE_OFF
+	profiler_report("profile.txt", "profile.json");
+#endif
+	if (opts().hw_counters) {
+		kernel_counters::report(opts().data_dir + opts().hw_counters_json);
+	}
 }
@@ -9,6 +9,7 @@
 #include "octotiger/defs.hpp"
 #include "octotiger/diagnostics.hpp"
 #include "octotiger/future.hpp"
+#include "octotiger/load_balance.hpp"
 #include "octotiger/node_client.hpp"
 #include "octotiger/node_registry.hpp"
 #include "octotiger/node_server.hpp"
@@ -66,7 +67,7 @@ future<node_count_type> node_client::regrid_gather(bool rb) const {
 
 
 node_count_type node_server::regrid_gather(bool rebalance_only) {
-	node_registry::delete_(my_location);
+	hydro_bounds_current = false;
 	node_count_type count;
 	count.total = 1;
 	count.leaf = is_refined ? 0 : 1;
@@ -80,6 +81,9 @@ node_count_type node_server::regrid_gather(bool rebalance_only) {
 				}
 				std::fill_n(children.begin(), NCHILD, node_client());
 				is_refined = false;
+				count.derefined = 1;
+			} else if (refinement_held) {
+				count.held = 1;
 			}
 		}
 
@@ -96,6 +100,9 @@ node_count_type node_server::regrid_gather(bool rebalance_only) {
 				child_descendant_count[ci] = child_cnt.total;
 				count.leaf += child_cnt.leaf;
 				count.total += child_cnt.total;
+				count.refined += child_cnt.refined;
+				count.derefined += child_cnt.derefined;
+				count.held += child_cnt.held;
 			}
 		} else {
 			count.leaf = 1;
@@ -111,6 +118,8 @@ node_count_type node_server::regrid_gather(bool rebalance_only) {
 
 			/* Turning refinement on*/
 			is_refined = true;
+			refined_at_step = step_num;
+			count.refined = 1;
 
 			for (auto &ci : geo::octant::full_set()) {
 				child_descendant_count[ci] = 1;
@@ -193,7 +202,7 @@ void node_server::regrid_scatter(integer a_, integer total) {
 		++a;
 		integer index = 0;
 		for (auto &ci : geo::octant::full_set()) {
-			const integer loc_index = a * options::all_localities.size() / total;
+			const integer loc_index = load_balance_locality(a, total);
 			const auto child_loc = options::all_localities[loc_index];
 			if (children[ci].empty()) {
 				futs[index++] = create_child(child_loc, ci).then([this, ci, a, total](future<hpx::id_type> &&child) {
@@ -205,8 +214,11 @@ void node_server::regrid_scatter(integer a_, integer total) {
 				integer current_child_id = hpx::naming::get_locality_id_from_gid(id.get_gid());
 				auto current_child_loc = options::all_localities[current_child_id];
 				if (child_loc != current_child_loc) {
-					futs[index++] = children[ci].copy_to_locality(child_loc).then([this, ci, a, total](future<hpx::id_type> &&child) {
+					hpx::chrono::high_resolution_timer timer;
+					futs[index++] = children[ci].copy_to_locality(child_loc).then([this, ci, a, total, timer](future<hpx::id_type> &&child) {
 						children[ci] = GET(child);
+						// Several children may be migrated at the same time
+						timings::add_time(timings_.times_[timings::time_migration], timer.elapsed());
 						GET(children[ci].regrid_scatter(a, total));
 					});
 				} else {
@@ -241,25 +253,33 @@ void node_server::regrid_scatter(integer a_, integer total) {
   }
 }
 
-node_count_type node_server::regrid(const hpx::id_type &root_gid, real omega, real new_floor, bool rb, bool grav_energy_comp) {
+node_count_type node_server::regrid(const hpx::id_type &root_gid, real omega, real new_floor, bool rb, bool grav_energy_comp,
+		bool defer_gravity, bool refinement_checked) {
 	timings::scope ts(timings_, timings::time_regrid);
 	hpx::chrono::high_resolution_timer timer;
 	assert(grid_ptr != nullptr);
 	print("-----------------------------------------------\n");
-	if (!rb) {
+	// Every node registers again in form_tree
+	node_registry::clear();
+	if (!rb && !refinement_checked) {
 		print("checking for refinement\n");
 		check_for_refinement(omega, new_floor);
-	} else {
-		node_registry::clear();
 	}
 	print("regridding\n");
 	real tstart = timer.elapsed();
 	auto a = regrid_gather(rb);
 	real tstop = timer.elapsed();
 	print("Regridded tree in %f seconds\n", real(tstop - tstart));
+	if (!rb) {
+		print("%i nodes refined, %i derefined, %i kept refined by the hysteresis\n", int(a.refined), int(a.derefined), int(a.held));
+	}
 	print("rebalancing %i nodes with %i leaves\n", int(a.total), int(a.leaf));
 	tstart = timer.elapsed();
 	regrid_scatter(0, a.total);
+	// Keep the arrays the next regrid may need if it refines or derefines as much as this one
+	const auto churn = NCHILD * std::max(a.refined, a.derefined);
+	const auto nloc = options::all_localities.size();
+	grid::trim_storage_pool((churn + nloc - 1) / nloc);
 	tstop = timer.elapsed();
 	print("Rebalanced tree in %f seconds\n", real(tstop - tstart));
 	assert(grid_ptr != nullptr);
@@ -269,8 +289,14 @@ node_count_type node_server::regrid(const hpx::id_type &root_gid, real omega, re
 	print("%i amr boundaries\n", a.amr_bnd);
 	tstop = timer.elapsed();
 	print("Formed tree in %f seconds\n", real(tstop - tstart));
-	print("solving gravity\n");
-	solve_gravity(grav_energy_comp, false);
+	if (defer_gravity) {
+		// The energy correction is relative to the potential before the first deferred regrid
+		gravity_stale_energy = grav_energy_comp && (gravity_stale_energy || !gravity_stale);
+		gravity_stale = true;
+	} else {
+		print("solving gravity\n");
+		solve_gravity(grav_energy_comp, false);
+	}
 	double elapsed = timer.elapsed();
 	print("regrid done in %f seconds\n---------------------------------------\n", elapsed);
 	return a;
@@ -310,6 +336,7 @@ future<void> node_client::solve_gravity(bool ene, bool aonly) const {
 }
 
 void node_server::solve_gravity(bool ene, bool aonly) {
+	gravity_stale = false;
 	if (!opts().gravity) {
 		return;
 	}
@@ -329,4 +356,11 @@ void node_server::solve_gravity(bool ene, bool aonly) {
 		}
 	}
 }
+
+void node_server::solve_deferred_gravity() {
+	if (gravity_stale) {
+		print("solving gravity\n");
+		solve_gravity(gravity_stale_energy, false);
+	}
+}
 #endif
@@ -8,12 +8,16 @@
 
 #include "octotiger/diagnostics.hpp"
 #include "octotiger/future.hpp"
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/node_client.hpp"
 #include "octotiger/node_registry.hpp"
 #include "octotiger/node_server.hpp"
 #include "octotiger/options.hpp"
+#include "octotiger/problem.hpp"
 #include "octotiger/profiler.hpp"
 #include "octotiger/taylor.hpp"
+#include "octotiger/telemetry.hpp"
+#include "octotiger/tracer.hpp"
 
 #include <hpx/include/lcos.hpp>
 #include <hpx/include/run_as.hpp>
@@ -42,7 +46,6 @@ void node_server::check_for_refinement(real omega, real new_floor) {
 			opts().refinement_floor = new_floor;
 		}
 	}
-	node_registry::delete_(my_location);
 	bool rc = false;
 	std::array<future<void>, NCHILD + 1> futs;
 	for (integer i = 0; i != NCHILD + 1; ++i) {
@@ -54,12 +57,24 @@ void node_server::check_for_refinement(real omega, real new_floor) {
 			futs[index++] = child.check_for_refinement(omega, new_floor);
 		}
 	}
-	if (opts().hydro || opts().problem == AMR_TEST) {
+	if ((opts().hydro || opts().problem == AMR_TEST) && !hydro_bounds_current) {
 		all_hydro_bounds();
 	}
 	if (!rc) {
 		rc = grid_ptr->refine_me(my_location.level(), new_floor);
 	}
+	refinement_held = false;
+	if (!rc && is_refined) {
+		// Hysteresis: a refined node stays refined for refinement_min_lifetime steps, and after that
+		// until its criteria fail with the lower derefinement floor as well
+		if (step_num < refined_at_step + opts().refinement_min_lifetime) {
+			refinement_held = true;
+		} else if (opts().derefinement_floor_ratio < 1.0) {
+			refinement_hysteresis_scope scope(true);
+			refinement_held = grid_ptr->refine_me(my_location.level(), new_floor);
+		}
+		rc = refinement_held;
+	}
 	if (rc) {
 		if (refinement_flag++ == 0) {
 			if (!parent.empty()) {
@@ -73,6 +88,51 @@ void node_server::check_for_refinement(real omega, real new_floor) {
 
 }
 
+using pending_refinement_action_type = node_server::pending_refinement_action;
+HPX_REGISTER_ACTION(pending_refinement_action_type);
+
+future<node_count_type> node_client::pending_refinement(bool clear) const {
+	return hpx::async<typename node_server::pending_refinement_action>(get_unmanaged_gid(), clear);
+}
+
+// Counts the leaves check_for_refinement flagged to be refined and the refined nodes it left unflagged, which
+// regrid_gather would derefine. With clear the flags are reset, as regrid_scatter does after a regrid.
+node_count_type node_server::pending_refinement(bool clear) {
+	node_count_type count;
+	std::array<future<node_count_type>, NCHILD> futs;
+	if (is_refined) {
+		integer index = 0;
+		for (auto &child : children) {
+			futs[index++] = child.pending_refinement(clear);
+		}
+		count.derefined = refinement_flag == 0 ? 1 : 0;
+	} else {
+		count.refined = refinement_flag != 0 ? 1 : 0;
+	}
+	if (clear) {
+		refinement_flag = 0;
+	}
+	if (is_refined) {
+		for (auto &f : futs) {
+			const auto child_cnt = GET(f);
+			count.refined += child_cnt.refined;
+			count.derefined += child_cnt.derefined;
+		}
+	}
+	return count;
+}
+
+bool node_server::refinement_changed(real omega, real new_floor) {
+	print("checking for refinement\n");
+	check_for_refinement(omega, new_floor);
+	const auto pending = pending_refinement(false);
+	if (pending.refined + pending.derefined == 0) {
+		pending_refinement(true);
+		return false;
+	}
+	return true;
+}
+
 using enforce_bc_action_type = node_server::enforce_bc_action;
 HPX_REGISTER_ACTION(enforce_bc_action_type);
 
@@ -129,7 +189,7 @@ future<hpx::id_type> node_server::copy_to_locality(const hpx::id_type &id) {
 		}
 	}
 	auto rc = hpx::new_<node_server>(id, my_location, step_num, bool(is_refined), current_time, rotational_time, child_descendant_count, std::move(*grid_ptr),
-			cids, std::size_t(hcycle), std::size_t(rcycle), std::size_t(gcycle), position);
+			cids, std::size_t(hcycle), std::size_t(rcycle), std::size_t(gcycle), position, refined_at_step);
 	clear_family();
 	parent = hpx::invalid_id;
 	std::fill(neighbors.begin(), neighbors.end(), hpx::invalid_id);
@@ -177,29 +237,31 @@ analytic_t node_server::compare_analytic() {
 
 		const auto ml = opts().max_level;
 		const auto dxmin = 2.0 * opts().xscale / INX / double(1 << ml);
-		FILE *fp = fopen("L1.dat", "at");
-		fprintf(fp, "%e %i ", dxmin, int(ml));
-		for (integer field = 0; field != opts().n_fields; ++field) {
-			fprintf(fp, "%e ", a.l1[field] / vol);
-		}
-		fprintf(fp, "\n");
-		fclose(fp);
+		io::submit([&]() {
+			FILE *fp = fopen("L1.dat", "at");
+			fprintf(fp, "%e %i ", dxmin, int(ml));
+			for (integer field = 0; field != opts().n_fields; ++field) {
+				fprintf(fp, "%e ", a.l1[field] / vol);
+			}
+			fprintf(fp, "\n");
+			fclose(fp);
 
-		fp = fopen("L2.dat", "at");
-		fprintf(fp, "%e %i ", dxmin, int(ml));
-		for (integer field = 0; field != opts().n_fields; ++field) {
-			fprintf(fp, "%e ", std::sqrt(a.l2[field] / vol));
-		}
-		fprintf(fp, "\n");
-		fclose(fp);
+			fp = fopen("L2.dat", "at");
+			fprintf(fp, "%e %i ", dxmin, int(ml));
+			for (integer field = 0; field != opts().n_fields; ++field) {
+				fprintf(fp, "%e ", std::sqrt(a.l2[field] / vol));
+			}
+			fprintf(fp, "\n");
+			fclose(fp);
 
-		fp = fopen("Linf.dat", "at");
-		fprintf(fp, "%e %i ", dxmin, int(ml));
-		for (integer field = 0; field != opts().n_fields; ++field) {
-			fprintf(fp, "%e ", a.linf[field]);
-		}
-		fprintf(fp, "\n");
-		fclose(fp);
+			fp = fopen("Linf.dat", "at");
+			fprintf(fp, "%e %i ", dxmin, int(ml));
+			for (integer field = 0; field != opts().n_fields; ++field) {
+				fprintf(fp, "%e ", a.linf[field]);
+			}
+			fprintf(fp, "\n");
+			fclose(fp);
+		}).get();
 	}
 	return a;
 }
@@ -263,13 +325,32 @@ diagnostics_t node_server::diagnostics() {
 		return diagnostics_t();
 	}
 
+	snapshot_diagnostics();
+	return snapshot_diagnostics_sums(current_time, opts().gravity ? grid_ptr->center_of_mass() : space_vector(0.0));
+}
+
+hpx::future<diagnostics_t> node_server::diagnostics_async() {
+
+	if (opts().disable_diagnostics) {
+		return hpx::make_ready_future(diagnostics_t());
+	}
+
+	snapshot_diagnostics();
+	const real time = current_time;
+	const space_vector grid_com = opts().gravity ? grid_ptr->center_of_mass() : space_vector(0.0);
+	return hpx::async(traced_function([this, time, grid_com]() {
+		return snapshot_diagnostics_sums(time, grid_com);
+	}, "diagnostics_async::snapshot_diagnostics_sums", my_location));
+}
+
+diagnostics_t node_server::snapshot_diagnostics_sums(real time, const space_vector &grid_com) {
 	diagnostics_t diags;
 	for (integer i = 1; i != (opts().problem == DWD ? 5 : 2); ++i) {
 //		print( "%i\n", i );
 		diags.stage = i;
 		diags = diagnostics(diags).compute();
 		if (opts().gravity) {
-			diags.grid_com = grid_ptr->center_of_mass();
+			diags.grid_com = grid_com;
 
 		} else {
 			//TODO center of mass for non gravity runs
@@ -277,56 +358,28 @@ diagnostics_t node_server::diagnostics() {
 	}
 	if (!diags.failed && !opts().disable_diagnostics) {
 
-		FILE *fp = fopen((opts().data_dir + "binary.dat").c_str(), "at");
-		if (fp) {
-			fprintf(fp, "%13e ", current_time);
-			fprintf(fp, "%13e ", (double) diags.a);
-			fprintf(fp, "%13e ", (double) diags.omega);
-			fprintf(fp, "%13e ", (double) diags.jorb);
-			for (integer s = 0; s != 2; ++s) {
-				const auto radius = std::pow(diags.roche_vol[s] / (4.0 / 3.0 * M_PI), 1. / 3.);
-				fprintf(fp, "%13e ", (double) diags.m[s]);				// 5 // 19
-				fprintf(fp, "%13e ", (double) diags.js[s]);
-				fprintf(fp, "%13e ", (double) diags.lz1[s]);
-				fprintf(fp, "%13e ", (double) diags.lz2[s]);
-				fprintf(fp, "%13e ", (double) diags.ekin[s]);           // 9  // 23
-				fprintf(fp, "%13e ", (double) diags.epot[s]);           // 10 // 24
-				fprintf(fp, "%13e ", (double) diags.eint[s]);           // 11 // 25
-				fprintf(fp, "%13e ", (double) diags.com[s][0]);			// 12 // 26
-				fprintf(fp, "%13e ", (double) diags.com[s][1]);			// 13 // 27
-				fprintf(fp, "%13e ", (double) diags.com_dot[s][0]);
-				fprintf(fp, "%13e ", (double) diags.com_dot[s][1]);
-				fprintf(fp, "%13e ", (double) radius);					// 16 // 30
-				fprintf(fp, "%13e ", (double) diags.Ts[s]);
-				fprintf(fp, "%13e ", (double) diags.z_moment[s]);       // 18  // 32
-			}
-			fprintf(fp, "%13e ", (double) diags.rho_max[0]); // 33
-			fprintf(fp, "%13e ", (double) diags.rho_max[1]); // 34
-			fprintf(fp, "%13e ", (double) diags.grid_com[0]); // 35
-			fprintf(fp, "%13e ", (double) diags.grid_com[1]); // 36
-			fprintf(fp, "%13e ", (double) diags.nonvacj); // 37
-			fprintf(fp, "%13e ", (double) diags.nonvacjlz); // 38
-			fprintf(fp, "%13e ", (double) diags.Torb); //39
-			fprintf(fp, "%13e ", (double) diags.grid_sum[rho_i]); //40
-			fprintf(fp, "%13e ", (double) diags.munbound1); //41
-			fprintf(fp, "%13e ", (double) diags.munbound2); //4@
-			fprintf(fp, "\n");
-			fclose(fp);
-			fp = fopen((opts().data_dir + "sums.dat").c_str(), "at");
-			fprintf(fp, "%.13e ", current_time);
-			for (integer i = 0; i != opts().n_fields; ++i) {
-				fprintf(fp, "%.13e ", (double) diags.grid_sum[i] + (double) diags.grid_out[i]);
-				fprintf(fp, "%.13e ", (double) diags.grid_out[i]);
-			}
-			for (integer i = 0; i != 3; ++i) {
-				fprintf(fp, "%.13e ", (double) diags.lsum[i]);
-			}
-			fprintf(fp, "\n");
-			fclose(fp);
-
-		} else {
-			print("Failed to write binary.dat %s\n", std::strerror(errno));
+		std::vector<double> row = { double(time), double(diags.a), double(diags.omega), double(diags.jorb) };
+		for (integer s = 0; s != 2; ++s) {
+			const auto radius = std::pow(diags.roche_vol[s] / (4.0 / 3.0 * M_PI), 1. / 3.);
+			row.insert(row.end(), { double(diags.m[s]), double(diags.js[s]), double(diags.lz1[s]), double(diags.lz2[s]),
+					double(diags.ekin[s]), double(diags.epot[s]), double(diags.eint[s]), double(diags.com[s][0]),
+					double(diags.com[s][1]), double(diags.com_dot[s][0]), double(diags.com_dot[s][1]), double(radius),
+					double(diags.Ts[s]), double(diags.z_moment[s]) });
+		}
+		row.insert(row.end(), { double(diags.rho_max[0]), double(diags.rho_max[1]), double(diags.grid_com[0]),
+				double(diags.grid_com[1]), double(diags.nonvacj), double(diags.nonvacjlz), double(diags.Torb),
+				double(diags.grid_sum[rho_i]), double(diags.munbound1), double(diags.munbound2) });
+		telemetry::record(telemetry::binary_stream, std::move(row));
+
+		std::vector<double> sums = { double(time) };
+		for (integer i = 0; i != opts().n_fields; ++i) {
+			sums.push_back(double(diags.grid_sum[i]) + double(diags.grid_out[i]));
+			sums.push_back(double(diags.grid_out[i]));
+		}
+		for (integer i = 0; i != 3; ++i) {
+			sums.push_back(double(diags.lsum[i]));
 		}
+		telemetry::record(telemetry::sums_stream, std::move(sums));
 	} else {
 		print("Failed to compute Roche geometry\n");
 	}
@@ -339,15 +392,35 @@ diagnostics_t node_server::root_diagnostics(const diagnostics_t &diags) {
 
 diagnostics_t node_server::diagnostics(const diagnostics_t &diags) {
 	if (is_refined) {
-		auto rc = hpx::async(hpx::util::annotated_function([&]() {
-			return child_diagnostics(diags);
-		}, "diagnostics::return_child_diagnostics"));
+		return child_diagnostics(diags);
+	} else {
+		timings::scope ts(timings_, timings::time_diagnostics);
+		return local_diagnostics(diags);
+	}
+}
+
+using snapshot_diagnostics_action_type = node_server::snapshot_diagnostics_action;
+HPX_REGISTER_ACTION(snapshot_diagnostics_action_type);
+
+future<void> node_client::snapshot_diagnostics() const {
+	return hpx::async<typename node_server::snapshot_diagnostics_action>(get_unmanaged_gid());
+}
+
+// Exchanges the boundaries once and copies the leaf states, all stages of the diagnostics then run on the copies
+void node_server::snapshot_diagnostics() {
+	if (is_refined) {
+		std::array<future<void>, NCHILD> futs;
+		for (integer ci = 0; ci != NCHILD; ++ci) {
+			futs[ci] = children[ci].snapshot_diagnostics();
+		}
 		all_hydro_bounds();
-		auto diags = GET(rc);
-		return diags;
+		for (auto &f : futs) {
+			GET(f);
+		}
 	} else {
 		all_hydro_bounds();
-		return local_diagnostics(diags);
+		timings::scope ts(timings_, timings::time_diagnostics);
+		grid_ptr->snapshot_diagnostics();
 	}
 }
 
@@ -452,6 +525,8 @@ bool operator!=(const node_client &nc, const hpx::id_type &id) {
 }
 
 int node_server::form_tree(hpx::id_type self_gid, hpx::id_type parent_gid, std::vector<hpx::id_type> neighbor_gids) {
+	// Inclusive of the time spent waiting for the children
+	timings::scope ts(timings_, timings::time_form_tree);
 	int amr_bnd = 0;
 
 	std::fill(nieces.begin(), nieces.end(), 0);
@@ -524,9 +599,9 @@ int node_server::form_tree(hpx::id_type self_gid, hpx::id_type parent_gid, std::
 			const auto &neighbor = neighbors[f.to_direction()];
 			if (!neighbor.empty()) {
 				nfuts.push_back(neighbor.set_child_aunt(me.get_gid(), f ^ 1).then(
-                    hpx::util::annotated_function([this, f](future<set_child_aunt_type> &&n) {
+                    traced_function([this, f](future<set_child_aunt_type> &&n) {
 					nieces[f] = GET(n);
-				}, "node_server::form_tree::sync")));
+				}, "node_server::form_tree::sync", my_location)));
 			} else {
 				nieces[f] = -2;
 			}
@@ -3,25 +3,33 @@
 //  Distributed under the Boost Software License, Version 1.0. (See accompanying
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#include "octotiger/bench_recorder.hpp"
+#include "octotiger/comm_counters.hpp"
+#include "octotiger/conserved_sums.hpp"
 #include "octotiger/defs.hpp"
 #include "octotiger/future.hpp"
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/load_balance.hpp"
 #include "octotiger/node_client.hpp"
 #include "octotiger/node_server.hpp"
 #include "octotiger/options.hpp"
 #include "octotiger/problem.hpp"
 #include "octotiger/real.hpp"
+#include "octotiger/telemetry.hpp"
+#include "octotiger/timestep_reduce.hpp"
+#include "octotiger/tracer.hpp"
 #include "octotiger/util.hpp"
 
 #include <cerrno>
 
 #include <hpx/include/lcos.hpp>
-#include <hpx/include/run_as.hpp>
 #include <hpx/include/util.hpp>
 #include <hpx/collectives/broadcast.hpp>
 
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include <memory>
 
 #if !defined(HPX_COMPUTE_DEVICE_CODE)
 
@@ -29,6 +37,7 @@ using send_gravity_boundary_action_type = node_server::send_gravity_boundary_act
 HPX_REGISTER_ACTION (send_gravity_boundary_action_type);
 
 void node_client::send_gravity_boundary(gravity_boundary_type &&data, const geo::direction &dir, bool monopole, std::size_t cycle) const {
+	comm_counters::record(comm_counters::gravity_boundary, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_gravity_boundary_action>(get_unmanaged_gid(), std::move(data), dir, monopole, cycle);
 }
 
@@ -48,6 +57,7 @@ void node_server::recv_gravity_expansions(expansion_pass_type &&v) {
 }
 
 void node_client::send_gravity_expansions(expansion_pass_type &&data) const {
+	comm_counters::record(comm_counters::gravity_expansions, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_gravity_expansions_action>(get_unmanaged_gid(), std::move(data));
 }
 
@@ -55,6 +65,7 @@ using send_gravity_multipoles_action_type = node_server::send_gravity_multipoles
 HPX_REGISTER_ACTION (send_gravity_multipoles_action_type);
 
 void node_client::send_gravity_multipoles(multipole_pass_type &&data, const geo::octant &ci) const {
+	comm_counters::record(comm_counters::gravity_multipoles, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_gravity_multipoles_action>(get_unmanaged_gid(), std::move(data), ci);
 }
 
@@ -66,6 +77,7 @@ using send_hydro_boundary_action_type = node_server::send_hydro_boundary_action;
 HPX_REGISTER_ACTION (send_hydro_boundary_action_type);
 
 void node_client::send_hydro_boundary(std::vector<real> &&data, const geo::direction &dir, std::size_t cycle) const {
+	comm_counters::record(comm_counters::hydro_boundary, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_hydro_boundary_action>(get_unmanaged_gid(), std::move(data), dir, cycle);
 }
 
@@ -81,6 +93,7 @@ using send_hydro_amr_boundary_action_type = node_server::send_hydro_amr_boundary
 HPX_REGISTER_ACTION (send_hydro_amr_boundary_action_type);
 
 void node_client::send_hydro_amr_boundary(std::vector<real> &&data, const geo::direction &dir, std::size_t cycle) const {
+  comm_counters::record(comm_counters::hydro_amr_boundary, is_local(), comm_counters::payload_bytes(data));
   hpx::apply<typename node_server::send_hydro_amr_boundary_action>(get_unmanaged_gid(), std::move(data), dir, cycle);
 }
 
@@ -95,6 +108,7 @@ using send_flux_check_action_type = node_server::send_flux_check_action;
 HPX_REGISTER_ACTION (send_flux_check_action_type);
 
 void node_client::send_flux_check(std::vector<real> &&data, const geo::direction &dir, std::size_t cycle) const {
+	comm_counters::record(comm_counters::flux_check, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_flux_check_action>(get_unmanaged_gid(), std::move(data), dir, cycle);
 }
 
@@ -113,6 +127,7 @@ void node_server::recv_hydro_children(std::vector<real> &&data, const geo::octan
 }
 
 void node_client::send_hydro_children(std::vector<real> &&data, const geo::octant &ci, std::size_t cycle) const {
+	comm_counters::record(comm_counters::hydro_children, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_hydro_children_action>(get_unmanaged_gid(), std::move(data), ci, cycle);
 }
 
@@ -120,6 +135,7 @@ using send_hydro_flux_correct_action_type = node_server::send_hydro_flux_correct
 HPX_REGISTER_ACTION (send_hydro_flux_correct_action_type);
 
 void node_client::send_hydro_flux_correct(std::vector<real> &&data, const geo::face &face, const geo::octant &ci) const {
+	comm_counters::record(comm_counters::hydro_flux_correct, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_hydro_flux_correct_action>(get_unmanaged_gid(), std::move(data), face, ci);
 }
 
@@ -267,6 +283,7 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 //	output_all("X", 0, false);
 
 	if (!opts().hydro && !opts().radiation) {
+		solve_deferred_gravity();
 //		diagnostics();
 		if (!opts().disable_output) {
 			output_all(this, "final", output_cnt, true);
@@ -279,12 +296,20 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
         auto start_all_gravity = std::chrono::high_resolution_clock::now(); 
         auto min_duration = std::chrono::milliseconds::max();
         auto max_duration = std::chrono::milliseconds::min();
-        for (int iteration = 0; iteration < opts().stop_step; iteration++) {
+        bench_recorder bench;
+        const int iterations = opts().bench ? opts().bench_warmup_steps + opts().bench_steps : opts().stop_step;
+        for (int iteration = 0; iteration < iterations; iteration++) {
+          if (opts().bench && iteration == opts().bench_warmup_steps) {
+            bench.start_measurement();
+          }
           std::cout << "Pure-gravity iteration " << iteration << std::endl;
           auto start = std::chrono::high_resolution_clock::now(); 
           solve_gravity(true, false);
           auto stop = std::chrono::high_resolution_clock::now(); 
           auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start); 
+          if (opts().bench) {
+            bench.record_block(iteration, 1, std::chrono::duration<double>(stop - start).count(), ngrids);
+          }
           std::cout << "--> " << iteration + 1 << ". FMM iteration took: " << duration.count() << " ms" << std::endl; 
           if (duration.count() < min_duration.count())
             min_duration = duration;
@@ -295,9 +320,13 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
         auto stop_all_gravity = std::chrono::high_resolution_clock::now(); 
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop_all_gravity - start_all_gravity); 
         std::cout << "==> Overall execution time: " << duration.count() << " ms" << std::endl; 
-        std::cout << "==> Average iteration execution time: " << duration.count() / opts().stop_step << " ms" << std::endl; 
+        std::cout << "==> Average iteration execution time: " << duration.count() / iterations << " ms" << std::endl; 
         std::cout << "==> Minimal iteration execution time: " << min_duration.count() << " ms" << std::endl; 
         std::cout << "==> Maximal iteration execution time: " << max_duration.count() << " ms" << std::endl; 
+        if (opts().bench) {
+          bench.stop_measurement();
+          bench.write(opts().data_dir + opts().bench_json);
+        }
 			}
 			if (!opts().disable_output) {
 				output_all(this, "analytic", output_cnt, true);
@@ -330,15 +359,15 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 	auto fut_ptr = me.get_ptr();
 	node_server *root_ptr = GET(fut_ptr);
 	if (!opts().output_filename.empty()) {
+		solve_deferred_gravity();
 		diagnostics();
-		solve_gravity(false, false);
 		output_all(this, opts().output_filename, output_cnt, false);
 		return;
 	}
 
+	// Potential of the startup tree, also needed by the energy correction of the regrid below
+	solve_deferred_gravity();
 	if (opts().stop_step != 0) {
-		print("Solving gravity\n");
-		solve_gravity(false, false);
 		ngrids = regrid(me.get_gid(), grid::get_omega(), -1, false);
 	}
 
@@ -352,23 +381,38 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 	print("%e %e\n", root_ptr->get_rotation_count(), output_dt);
 
 	real bench_start, bench_stop;
+	bench_recorder bench;
+	diagnostics_t diags;
+	integer next_diagnostics_step = 0;
 	while (current_time < opts().stop_time) {
 		timings::scope ts(timings_, timings::time_total);
 		if (step_num > opts().stop_step)
 			break;
 		auto time_start = std::chrono::high_resolution_clock::now();
-		auto diags = diagnostics();
 		if (opts().stop_step == 0) {
+			diagnostics();
 			return;
 		}
+		// Taken from a snapshot of the tree, so the diagnostics overlap the output and the steps of this block
+		hpx::future<diagnostics_t> diags_fut;
+		if (step_num >= next_diagnostics_step) {
+			diags_fut = diagnostics_async();
+			next_diagnostics_step = step_num + opts().diagnostics_freq;
+		}
 		if (!opts().disable_output && root_ptr->get_rotation_count() / output_dt >= output_cnt) {
 			static bool first_call = true;
 			if (opts().rewrite_silo || !first_call || (opts().restart_filename == "")) {
 				print("doing silo out...\n");
 				std::string fname = "X." + std::to_string(int(output_cnt));
-				output_all(this, fname, output_cnt, first_call);
+				{
+					timings::scope ts(timings_, timings::time_io);
+					output_all(this, fname, output_cnt, first_call);
+				}
 				if (opts().rewrite_silo) {
 					print("Exiting after rewriting SILO\n");
+					if (diags_fut.valid()) {
+						GET(diags_fut);
+					}
 					return;
 				}
 			}
@@ -382,13 +426,22 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 
 		real dt = 0;
 		integer next_step = (std::min)(step_num + refinement_freq(), opts().stop_step + 1);
+		// Benchmarks time whole refinement blocks, so the steps of a block stay pipelined as in a normal run
+		if (opts().bench && bench_recorder::is_measured(step_num)) {
+			bench.start_measurement();
+		}
+		if (opts().trace_start_step >= 0 && !tracer_active && step_num < opts().trace_start_step + opts().trace_steps
+				&& next_step > opts().trace_start_step) {
+			tracer_enable_all(true);
+		}
 		real omega_dot = 0.0, omega = 0.0, theta = 0.0, theta_dot = 0.0;
 
 		if ((opts().problem == DWD) && (step_num % refinement_freq() == 0)) {
 			print("dwd step...\n");
 			auto dt = GET(step(next_step - step_num));
-			if (!opts().disable_diagnostics) {
+			if (diags_fut.valid()) {
 				print("diagnostics...\n");
+				diags = GET(diags_fut);
 			}
 			omega = grid::get_omega();
 
@@ -409,27 +462,26 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 		} else {
 			print("normal step...\n");
 			dt = GET(step(next_step - step_num));
+			if (diags_fut.valid()) {
+				diags = GET(diags_fut);
+			}
 			omega = grid::get_omega();
 		}
 
 		double time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - time_start).count();
+		if (opts().bench) {
+			bench.record_block(step_num, next_step - step_num, time_elapsed, ngrids);
+		}
 
-		// run output on separate thread
 		if (!opts().disable_output) {
-			hpx::threads::run_as_os_thread([=]() {
-				FILE *fp = fopen((opts().data_dir + "step.dat").c_str(), "at");
-				if (fp == NULL) {
-					print( "Unable to open step.dat for writing %s\n", std::strerror(errno));
-				} else {
-					const auto vr = sqrt(sqr(dt_.ur[sx_i]) + sqr(dt_.ur[sy_i]) + sqr(dt_.ur[sz_i])) / dt_.ur[0];
-					const auto vl = sqrt(sqr(dt_.ul[sx_i]) + sqr(dt_.ul[sy_i]) + sqr(dt_.ul[sz_i])) / dt_.ul[0];
-					fprintf(fp, "%i %e %e %e %e %e %e %e %e %e %e %e %e %i %i %i %i\n", int(next_step - 1), double(t), double(dt_.dt), time_elapsed, rotational_time, dt_.x, dt_.y, dt_.z, dt_.a, dt_.ur[0], dt_.ul[0], vr,vl,dt_.dim, int(ngrids.total), int(ngrids.leaf), int(ngrids.amr_bnd));
-					fclose(fp);
-				}
-			});     // do not wait for it to finish
+			const auto vr = sqrt(sqr(dt_.ur[sx_i]) + sqr(dt_.ur[sy_i]) + sqr(dt_.ur[sz_i])) / dt_.ur[0];
+			const auto vl = sqrt(sqr(dt_.ul[sx_i]) + sqr(dt_.ul[sy_i]) + sqr(dt_.ul[sz_i])) / dt_.ul[0];
+			telemetry::record(telemetry::step_stream, { double(next_step - 1), double(t), double(dt_.dt), time_elapsed,
+					double(rotational_time), dt_.x, dt_.y, dt_.z, dt_.a, dt_.ur[0], dt_.ul[0], vr, vl, double(dt_.dim),
+					double(ngrids.total), double(ngrids.leaf), double(ngrids.amr_bnd) });
 		}
 
-		hpx::threads::run_as_os_thread(
+		io::submit(
 				[=]() {
 					const auto vr = sqrt(sqr(dt_.ur[sx_i]) + sqr(dt_.ur[sy_i]) + sqr(dt_.ur[sz_i])) / dt_.ur[0];
 					const auto vl = sqrt(sqr(dt_.ul[sx_i]) + sqr(dt_.ul[sy_i]) + sqr(dt_.ul[sz_i])) / dt_.ul[0];
@@ -442,6 +494,9 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 				});     // do not wait for output to finish
 
 		step_num = next_step;
+		if (opts().conserved_sums_freq > 0) {
+			conserved_sums_drain(false);
+		}
 
 		if (step_num % refinement_freq() == 0) {
 			real new_floor = opts().refinement_floor;
@@ -451,25 +506,31 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 				print("New refinement floor = %e\n", new_floor);
 			}
 
-			ngrids = regrid(me.get_gid(), omega, new_floor, false);
+			const auto regrid_start = std::chrono::high_resolution_clock::now();
+			// The tree only changes if check_for_refinement flags a node to be refined or derefined
+			if (opts().refinement_adaptive && !refinement_changed(omega, new_floor)) {
+				print("Skipping the regrid after step %i, no node is refined or derefined\n", int(step_num));
+			} else {
+				if (opts().load_balance_report || opts().load_balance_weighted) {
+					load_balance_report(step_num);
+				}
+				ngrids = regrid(me.get_gid(), omega, new_floor, false, true, false, opts().refinement_adaptive);
+			}
+			if (opts().bench) {
+				bench.record_regrid(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - regrid_start).count());
+			}
 
-			// run output on separate thread
-			auto need_break = hpx::threads::run_as_os_thread([&]() {
-				//		set_omega_and_pivot();
+			if (scf) {
 				bench_stop = hpx::chrono::high_resolution_clock::now() / 1e9;
-				if (scf || opts().bench) {
-					print("Total time = %e s\n", double(bench_stop - bench_start));
-					if (!opts().disable_output) {
-						FILE *fp = fopen((opts().data_dir + "bench.dat").c_str(), "at");
-						fprintf(fp, "%i %e\n", int(options::all_localities.size()), double(bench_stop - bench_start));
-						fclose(fp);
-					}
-					return true;
-				}
-				return false;
-			});
-			if (GET(need_break))
+				print("Total time = %e s\n", double(bench_stop - bench_start));
 				break;
+			}
+		}
+		if (tracer_active && step_num >= opts().trace_start_step + opts().trace_steps) {
+			tracer_write_all(opts().data_dir + opts().trace_file);
+		}
+		if (opts().bench && bench_recorder::is_done(step_num)) {
+			break;
 		}
 		if (scf) {
 			bench_stop = hpx::chrono::high_resolution_clock::now() / 1e9;
@@ -479,6 +540,12 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 	}
 
 	bench_stop = hpx::chrono::high_resolution_clock::now() / 1e9;
+	if (opts().bench) {
+		bench.stop_measurement();
+	}
+	if (tracer_active) {
+		tracer_write_all(opts().data_dir + opts().trace_file);
+	}
 	{
 		timings::scope ts(timings_, timings::time_compare_analytic);
 
@@ -498,14 +565,11 @@ void node_server::execute_solver(bool scf, node_count_type ngrids) {
 		}
 	}
 
-	if (opts().bench && !opts().disable_output) {
-		hpx::threads::run_as_os_thread([&]() {
-
-			FILE *fp = fopen((opts().data_dir + "scaling.dat").c_str(), "at");
-			const auto nproc = options::all_localities.size();
-			fprintf(fp, "%i %e\n", int(nproc), float(bench_stop - bench_start));
-			fclose(fp);
-		}).get();
+	if (opts().conserved_sums_freq > 0) {
+		conserved_sums_drain(true);
+	}
+	if (opts().bench) {
+		bench.write(opts().data_dir + opts().bench_json);
 	}
 }
 
@@ -516,7 +580,7 @@ future<real> node_client::step(integer steps) const {
 	return hpx::async<typename node_server::step_action>(get_unmanaged_gid(), steps);
 }
 
-void node_server::refined_step() {
+bool node_server::refined_step(bool lagged) {
 
 //#if HPX_HAVE_ITTNOTIFY != 0 && !defined(HPX_HAVE_APEX)
 //	static hpx::util::itt::string_handle sh("node_server::refined_step");
@@ -528,11 +592,18 @@ void node_server::refined_step() {
 	real cfl0 = opts().cfl;
 
 	real a = std::numeric_limits<real>::min();
+	const real lag_dt = lagged ? lagged_timestep() : ZERO;
+	const bool full_bounds = full_bounds_at_step_end();
 	all_hydro_bounds();
 	timestep_t tstep;
 	tstep.dt = std::numeric_limits<real>::max();
-	local_timestep_channels[NCHILD].set_value(tstep);
-	auto dt_fut = global_timestep_channel.get_future();
+	hpx::shared_future<timestep_t> dt_fut;
+	if (opts().timestep_all_reduce) {
+		dt_fut = timestep_reduce::contribute(tstep);
+	} else {
+		local_timestep_channels[NCHILD].set_value(tstep);
+		dt_fut = global_timestep_channel.get_future();
+	}
 
 	for (integer rk = 0; rk < NRK; ++rk) {
 
@@ -541,20 +612,27 @@ void node_server::refined_step() {
 			compute_fmm(DRHODT, false);
 			compute_fmm(RHO, true);
 		}
-		rk == NRK - 1 ? energy_hydro_bounds() : all_hydro_bounds();
+		rk == NRK - 1 && !full_bounds ? energy_hydro_bounds() : all_hydro_bounds();
 
 	}
 
-	dt_ = GET(dt_fut);
+	if (lag_dt > ZERO) {
+		if (!accept_lagged_timestep(dt_fut, lag_dt)) {
+			return false;
+		}
+	} else {
+		dt_ = GET(dt_fut);
+	}
 	update();
 	if (opts().radiation) {
 		compute_radiation(dt_.dt, grid_ptr->get_omega());
 		all_hydro_bounds();
 	}
-
+	hydro_bounds_current = full_bounds;
+	return true;
 }
 
-future<void> node_server::nonrefined_step() {
+future<bool> node_server::nonrefined_step(bool lagged) {
 //#if HPX_HAVE_ITTNOTIFY != 0 && !defined(HPX_HAVE_APEX)
 //	static hpx::util::itt::string_handle sh("node_server::nonrefined_step");
 //	hpx::util::itt::task t(hpx::get_thread_itt_domain(), sh);
@@ -565,64 +643,134 @@ future<void> node_server::nonrefined_step() {
 
 	real cfl0 = opts().cfl;
 	dt_.dt = ZERO;
+	// Read before this node contributes to the reduction of the step
+	const real lag_dt = lagged ? lagged_timestep() : ZERO;
+	const bool full_bounds = full_bounds_at_step_end();
 
 	all_hydro_bounds();
 
 	grid_ptr->store();
 	future<void> fut = hpx::make_ready_future();
 
-	hpx::shared_future<timestep_t> dt_fut = global_timestep_channel.get_future();
+	auto step_dt = std::make_shared<hpx::shared_future<timestep_t>>();
+	if (!opts().timestep_all_reduce) {
+		*step_dt = global_timestep_channel.get_future();
+	}
 
 	for (integer rk = 0; rk < NRK; ++rk) {
 
 		fut = fut.then(hpx::launch::async_policy(hpx::threads::thread_priority::boost),
-		hpx::util::annotated_function(
-				[rk, cfl0, this, dt_fut](future<void> f) {
+		traced_function(
+				[rk, cfl0, lag_dt, full_bounds, this, step_dt](future<void> f) {
 					GET(f);
           size_t current_hydro_promise = hcycle % (NRK + 1);
-					timestep_t a = grid_ptr->compute_fluxes(); // hydro kernels
-					future<void> fut_flux = exchange_flux_corrections();
-					fut_flux.get();
+					grid_ptr->acquire_stage_scratch();
+					timestep_t a;
+					{
+						timings::scope ts(timings_, timings::time_reconstruct_flux);
+						a = grid_ptr->compute_fluxes(); // hydro kernels
+					}
+					{
+						timings::scope ts(timings_, timings::time_flux_correction);
+						future<void> fut_flux = exchange_flux_corrections();
+						fut_flux.get();
+					}
 //					a = std::max(a, grid_ptr->compute_positivity_speed_limit());
 					if (rk == 0) {
 						const real dx = TWO * grid::get_scaling_factor() / real(INX << my_location.level());
 						dt_ = a;
 						dt_.dt = cfl0 * dx / a.a;
 						if (opts().stop_time > 0.0) {
-							const real maxdt = (opts().stop_time - current_time) / (refinement_freq() - (step_num % refinement_freq()));
-							dt_.dt = std::min(dt_.dt, maxdt);
+							dt_.dt = std::min(dt_.dt, stop_time_timestep());
+						}
+						if (opts().timestep_all_reduce) {
+							*step_dt = timestep_reduce::contribute(dt_);
+						} else {
+							local_timestep_channels[NCHILD].set_value(dt_);
 						}
-						local_timestep_channels[NCHILD].set_value(dt_);
 					}
-					grid_ptr->compute_sources(current_time, rotational_time);
-					grid_ptr->compute_dudt();
+					{
+						timings::scope ts(timings_, timings::time_sources_next_u);
+						grid_ptr->compute_sources(current_time, rotational_time);
+						grid_ptr->compute_dudt();
+					}
 					compute_fmm(DRHODT, false);
 					if (rk == 0) {
-						dt_ = GET(dt_fut);
+						if (lag_dt > ZERO) {
+							// Checked against the reduction at the end of the step
+							dt_.dt = lag_dt;
+						} else {
+							dt_ = GET(*step_dt);
+						}
 					}
           if (!opts().gravity && opts().optimize_local_communication) {
             all_neighbors_got_hydro[(hcycle-1)%number_hydro_exchange_promises].get();
           }
-					grid_ptr->next_u(rk, current_time, dt_.dt);
+					{
+						timings::scope ts(timings_, timings::time_sources_next_u);
+						grid_ptr->next_u(rk, current_time, dt_.dt);
+					}
+					grid_ptr->release_stage_scratch();
 					compute_fmm(RHO, true);
-					rk == NRK - 1 ? energy_hydro_bounds() : all_hydro_bounds();
-				}, "node_server::nonrefined_step::compute_fluxes"));
+					rk == NRK - 1 && !full_bounds ? energy_hydro_bounds() : all_hydro_bounds();
+				}, "node_server::nonrefined_step::compute_fluxes", my_location));
 	}
 
-	return fut.then(hpx::launch::sync, hpx::util::annotated_function( [this](future<void> &&f) {
+	return fut.then(hpx::launch::sync, traced_function( [this, lag_dt, full_bounds, step_dt](future<void> &&f) {
 
 		GET(f);
 
+		if (lag_dt > ZERO && !accept_lagged_timestep(*step_dt, lag_dt)) {
+			grid_ptr->restore();
+			grid_ptr->release_step_scratch();
+			return false;
+		}
+		grid_ptr->release_step_scratch();
 		update();
 		if (opts().radiation) {
 			compute_radiation(dt_.dt, grid_ptr->get_omega());
 			all_hydro_bounds();
 		}
+		hydro_bounds_current = full_bounds;
+		return true;
 
-	}, "node_server::nonrefined_step::update" )
+	}, "node_server::nonrefined_step::update", my_location)
 	);
 }
 
+bool node_server::full_bounds_at_step_end() const {
+	// The last step before a regrid exchanges all fields after its last stage instead of the energy
+	// only, check_for_refinement then uses these boundaries
+	return opts().refinement_reuse_bounds && (step_num + 1) % refinement_freq() == 0;
+}
+
+real node_server::stop_time_timestep() const {
+	return (opts().stop_time - current_time) / (refinement_freq() - (step_num % refinement_freq()));
+}
+
+real node_server::lagged_timestep() const {
+	real dt = timestep_reduce::lagged_dt();
+	if (dt > ZERO && opts().stop_time > 0.0) {
+		dt = std::min(dt, stop_time_timestep());
+	}
+	return dt;
+}
+
+bool node_server::accept_lagged_timestep(const hpx::shared_future<timestep_t>& reduced_fut, real lag_dt) {
+	const timestep_t reduced = GET(reduced_fut);
+	if (reduced.dt < lag_dt) {
+		// All nodes get the same reduction, so either all of them accept the step or none
+		if (my_location.level() == 0) {
+			print("Step %i rejected: lagged timestep %e exceeds the CFL timestep %e, repeating it\n", int(step_num), double(lag_dt),
+					double(reduced.dt));
+		}
+		return false;
+	}
+	dt_ = reduced;
+	dt_.dt = lag_dt;
+	return true;
+}
+
 void node_server::update() {
 	grid_ptr->dual_energy_update();
 	current_time += dt_.dt;
@@ -643,49 +791,45 @@ future<real> node_server::local_step(integer steps) {
 			if (!is_refined) {
 				cumulative_node_count.leaf++;
 			}
-			constexpr auto full_set = geo::octant::full_set();
-			if (amr_flags.size()) {
-				for (auto &ci : full_set) {
-					const auto &flags = amr_flags[ci];
-					for (auto &dir : geo::direction::full_set()) {
-						if (dir.is_face()) {
-							if (flags[dir]) {
-								cumulative_node_count.amr_bnd++;
-							}
-						}
-					}
-				}
-			}
+			cumulative_node_count.amr_bnd += amr_boundary_count();
 		}
 
-		fut = fut.then(hpx::launch::async_policy(hpx::threads::thread_priority::boost), hpx::util::annotated_function([this, i, steps](future<void> fut) -> real {
+		fut = fut.then(hpx::launch::async_policy(hpx::threads::thread_priority::boost), traced_function([this, i, steps](future<void> fut) -> real {
 			GET(fut);
 			auto time_start = std::chrono::high_resolution_clock::now();
-			auto next_dt = timestep_driver_descend();
+			auto next_dt = opts().timestep_all_reduce ? hpx::make_ready_future() : timestep_driver_descend();
 
-			if (is_refined) {
-				refined_step();
-			} else {
-				GET(nonrefined_step());
+			if (!is_refined && opts().conserved_sums_freq > 0 && step_num % opts().conserved_sums_freq == 0) {
+				conserved_sums_submit(step_num, current_time, my_location.level(), grid_ptr->conserved_sums());
+			}
+			bool lagged = opts().timestep_lagged;
+			while (!(is_refined ? refined_step(lagged) : GET(nonrefined_step(lagged)))) {
+				// Rolled back to U0, the potential has to match it again before the step is repeated with
+				// the reduced timestep
+				compute_fmm(RHO, true);
+				lagged = false;
 			}
 
 			if (my_location.level() == 0) {
 				double time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - time_start).count();
 
-				hpx::threads::run_as_os_thread([=]() {
+				io::submit([=]() {
 					print("%i %e %e %e %e\n", int(step_num), double(current_time), double(dt_.dt), time_elapsed, rotational_time);
 				});  // do not wait for output to finish
 			}
 			++step_num;
 			GET(next_dt);
 			return dt_.dt;
-		}, "local_step::execute_step"));
+		}, "local_step::execute_step", my_location));
 	}
 	return fut;
 }
 
 future<real> node_server::step(integer steps) {
 	grid_ptr->set_coordinates();
+	if (my_location.level() == 0 && opts().timestep_all_reduce) {
+		timestep_reduce::prepare();
+	}
 
 	std::array<future<void>, NCHILD> child_futs;
 	if (is_refined) {
@@ -764,11 +908,11 @@ future<void> node_server::timestep_driver_descend() {
 			return;
 		}/*, "node_server::timestep_driver_descend")*/, futs);
 	} else {
-		return local_timestep_channels[NCHILD].get_future().then(hpx::launch::sync, hpx::util::annotated_function([this](future<timestep_t> &&f) {
+		return local_timestep_channels[NCHILD].get_future().then(hpx::launch::sync, traced_function([this](future<timestep_t> &&f) {
 			timestep_t dt = GET(f);
 			parent.set_local_timestep(my_location.get_child_index(), dt);
 			return;
-		}, "timestep_driver_descend::set_local_timestep")
+		}, "timestep_driver_descend::set_local_timestep", my_location)
 		);
 	}
 }
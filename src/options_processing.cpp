@@ -67,6 +67,9 @@ bool options::process_options(int argc, char *argv[]) {
 	("omega", po::value<real>(&(opts().omega))->default_value(0.0), "(initial) angular frequency")                          //
 	("v1309", po::value<bool>(&(opts().v1309))->default_value(false), "V1309 subproblem of DWD")                   //
 	("idle_rates", po::value<bool>(&(opts().idle_rates))->default_value(false), "show idle rates and locality info in SILO")                 //
+	("load_balance_report", po::value<bool>(&(opts().load_balance_report))->default_value(false), "report the load of every locality before each regrid (loadbalance.dat)") //
+	("load_balance_weighted", po::value<bool>(&(opts().load_balance_weighted))->default_value(false), "partition the tree by the measured throughput of the localities") //
+	("load_imbalance_threshold", po::value<real>(&(opts().load_imbalance_threshold))->default_value(1.1), "busy time max/mean above which load_balance_weighted repartitions") //
 	("eblast0", po::value<real>(&(opts().eblast0))->default_value(1.0), "energy for blast wave")     //
 	("rho_floor", po::value<real>(&(opts().rho_floor))->default_value(0.0), "density floor")     //
 	("tau_floor", po::value<real>(&(opts().tau_floor))->default_value(0.0), "entropy tracer floor")     //
@@ -116,12 +119,18 @@ bool options::process_options(int argc, char *argv[]) {
 	("donor_refine", po::value<integer>(&(opts().donor_refine))->default_value(0), "number of extra levels for donor")      //
 	("ngrids", po::value<integer>(&(opts().ngrids))->default_value(-1), "fix numbger of grids")                             //
 	("refinement_floor", po::value<real>(&(opts().refinement_floor))->default_value(1.0e-3), "density refinement floor")      //
+	("derefinement_floor_ratio", po::value<real>(&(opts().derefinement_floor_ratio))->default_value(1.0), "a refined node derefines only below this fraction of the density refinement floor") //
+	("refinement_min_lifetime", po::value<integer>(&(opts().refinement_min_lifetime))->default_value(0), "steps a newly refined node stays refined") //
+	("refinement_reuse_bounds", po::value<bool>(&(opts().refinement_reuse_bounds))->default_value(false), "exchange all fields after the last step before a regrid and check the refinement criteria without another boundary exchange") //
+	("refinement_adaptive", po::value<bool>(&(opts().refinement_adaptive))->default_value(false), "skip the regrid after a block of steps if check_for_refinement neither refines nor derefines a node") //
 	("theta", po::value<real>(&(opts().theta))->default_value(0.5), "controls nearness determination for FMM, must be between 1/3 and 1/2")               //
 	("eos", po::value<eos_type>(&(opts().eos))->default_value(IDEAL), "gas equation of state")                              //
         ("ipr_nr_tol", po::value<real>(&(opts().ipr_nr_tol))->default_value(1.48e-08), "Newton-Raphson tolerance for solving ideal gas plus radiation eos")                              //
         ("ipr_nr_maxiter", po::value<integer>(&(opts().ipr_nr_maxiter))->default_value(50), "Newton-Raphson max iterations for solving ideal gas plus radiation eos")                              //
         ("ipr_test", po::value<bool>(&(opts().ipr_test))->default_value(false), "test consistency of the ideal gas plus radiation eos")                              //
         ("ipr_eint_floor", po::value<real>(&(opts().ipr_eint_floor))->default_value(0.0), "floor thermal energy for ideal gas plus radiation eos")                              //
+        ("ipr_table", po::value<bool>(&(opts().ipr_table))->default_value(false), "use the tabulated temperature inversion instead of Newton-Raphson for the ideal gas plus radiation eos")                              //
+        ("ipr_table_polish", po::value<bool>(&(opts().ipr_table_polish))->default_value(true), "apply one Newton step after the table lookup of the ideal gas plus radiation eos")                              //
 	("hydro", po::value<bool>(&(opts().hydro))->default_value(true), "hydro on/off")    //
 	("radiation", po::value<bool>(&(opts().radiation))->default_value(false), "radiation on/off")    //
 	("correct_am_hydro", po::value<bool>(&(opts().correct_am_hydro))->default_value(false), "Angular momentum correction switch for hydro")    //
@@ -130,6 +139,22 @@ bool options::process_options(int argc, char *argv[]) {
 	("rad_implicit", po::value<bool>(&(opts().rad_implicit))->default_value(true), "implicit radiation on/off")    //
 	("gravity", po::value<bool>(&(opts().gravity))->default_value(true), "gravity on/off")    //
 	("bench", po::value<bool>(&(opts().bench))->default_value(false), "run benchmark") //
+	("bench_warmup_steps", po::value<integer>(&(opts().bench_warmup_steps))->default_value(2), "number of unmeasured steps before the benchmark") //
+	("bench_steps", po::value<integer>(&(opts().bench_steps))->default_value(10), "number of measured benchmark steps") //
+	("bench_json", po::value<std::string>(&(opts().bench_json))->default_value("bench.json"), "benchmark results file (in datadir)") //
+	("trace_start_step", po::value<integer>(&(opts().trace_start_step))->default_value(-1), "first step recorded by the task tracer (-1 = off)") //
+	("trace_steps", po::value<integer>(&(opts().trace_steps))->default_value(1), "number of steps recorded by the task tracer") //
+	("trace_buffer_size", po::value<integer>(&(opts().trace_buffer_size))->default_value(1 << 16), "task tracer events kept per OS thread") //
+	("trace_file", po::value<std::string>(&(opts().trace_file))->default_value("trace.json"), "task trace file in Chrome trace-event format (in datadir)") //
+	("hw_counters", po::value<bool>(&(opts().hw_counters))->default_value(false), "hardware counters and roofline of the host compute kernels") //
+	("hw_counters_json", po::value<std::string>(&(opts().hw_counters_json))->default_value("hw_counters.json"), "kernel roofline results file (in datadir)") //
+	("hw_fp_event", po::value<integer>(&(opts().hw_fp_event))->default_value(0), "raw perf event config (decimal) counting FP operations on this CPU (0 = off)") //
+	("roofline_peak_gflops", po::value<real>(&(opts().roofline_peak_gflops))->default_value(0.0), "peak GFLOP/s of one locality for the roofline (0 = unknown)") //
+	("roofline_peak_gbs", po::value<real>(&(opts().roofline_peak_gbs))->default_value(0.0), "peak memory bandwidth (GB/s) of one locality for the roofline (0 = unknown)") //
+	("io_threads", po::value<integer>(&(opts().io_threads))->default_value(-1), "cores of the dedicated I/O pool (0 = separate OS thread per I/O task, -1 = one core on nodes with at least 8 cores)") //
+	("telemetry_flush_interval", po::value<real>(&(opts().telemetry_flush_interval))->default_value(30.0), "seconds between writes of step.dat, binary.dat and sums.dat (0 = every step)") //
+	("telemetry_buffer_rows", po::value<integer>(&(opts().telemetry_buffer_rows))->default_value(1000), "rows of step.dat, binary.dat and sums.dat buffered before they are written") //
+	("telemetry_binary", po::value<bool>(&(opts().telemetry_binary))->default_value(false), "also write step.dat, binary.dat and sums.dat in binary columnar format (*.bin)") //
 	("datadir", po::value<std::string>(&(opts().data_dir))->default_value("./"), "directory for output") //
 	("output", po::value<std::string>(&(opts().output_filename))->default_value(""), "filename for output") //
 	("odt", po::value<real>(&(opts().output_dt))->default_value(1.0 / 100.0), "output frequency") //
@@ -144,6 +169,11 @@ bool options::process_options(int argc, char *argv[]) {
 	("disable_output", po::value<bool>(&(opts().disable_output))->default_value(false), "disable silo output") //
 	("disable_analytic", po::value<bool>(&(opts().disable_analytic))->default_value(false), "disable analytic step") //
 	("disable_diagnostics", po::value<bool>(&(opts().disable_diagnostics))->default_value(false), "disable diagnostics") //
+	("diagnostics_freq", po::value<integer>(&(opts().diagnostics_freq))->default_value(1), "minimum number of steps between two diagnostics (binary.dat, sums.dat)") //
+	("timestep_all_reduce", po::value<bool>(&(opts().timestep_all_reduce))->default_value(true), "reduce the timestep per locality and with one all_reduce instead of through the octree") //
+	("timestep_lagged", po::value<bool>(&(opts().timestep_lagged))->default_value(false), "advance with the timestep predicted from the previous step and repeat the rare step that violates the CFL condition (needs timestep_all_reduce)") //
+	("timestep_lag_safety", po::value<real>(&(opts().timestep_lag_safety))->default_value(0.9), "factor applied to the previous timestep for --timestep_lagged") //
+	("conserved_sums_freq", po::value<integer>(&(opts().conserved_sums_freq))->default_value(0), "steps between asynchronous conserved sums of the leaves (conserved.dat, 0 = off)") //
 	("problem", po::value<problem_type>(&(opts().problem))->default_value(NONE), "problem type")                            //
 	("restart_filename", po::value<std::string>(&(opts().restart_filename))->default_value(""), "restart filename")         //
 	("stop_time", po::value<real>(&(opts().stop_time))->default_value(std::numeric_limits<real>::max()), "time to end simulation") //
@@ -228,6 +258,32 @@ bool options::process_options(int argc, char *argv[]) {
     if (opts().cuda_streams_per_gpu > 0 && opts().cuda_number_gpus == 0) {
         opts().cuda_number_gpus = 1;
 	}
+	if (opts().bench) {
+		if (opts().bench_warmup_steps < 0 || opts().bench_steps < 1) {
+			std::cerr << "ERROR: --bench needs bench_warmup_steps >= 0 and bench_steps >= 1" << std::endl;
+			abort();
+		}
+		if (opts().stop_step < opts().bench_warmup_steps + opts().bench_steps) {
+			print("Raising stop_step to %i for the benchmark\n", int(opts().bench_warmup_steps + opts().bench_steps));
+			opts().stop_step = opts().bench_warmup_steps + opts().bench_steps;
+		}
+	}
+	if (opts().diagnostics_freq < 1 || opts().conserved_sums_freq < 0) {
+		std::cerr << "ERROR: diagnostics_freq must be >= 1 and conserved_sums_freq >= 0" << std::endl;
+		abort();
+	}
+	if (opts().derefinement_floor_ratio <= 0.0 || opts().derefinement_floor_ratio > 1.0 || opts().refinement_min_lifetime < 0) {
+		std::cerr << "ERROR: derefinement_floor_ratio must be in (0, 1] and refinement_min_lifetime >= 0" << std::endl;
+		abort();
+	}
+	if (opts().timestep_lagged && (!opts().timestep_all_reduce || opts().timestep_lag_safety <= 0.0 || opts().timestep_lag_safety > 1.0)) {
+		std::cerr << "ERROR: timestep_lagged needs timestep_all_reduce and 0 < timestep_lag_safety <= 1" << std::endl;
+		abort();
+	}
+	if (opts().trace_start_step >= 0 && (opts().trace_steps < 1 || opts().trace_buffer_size < 1)) {
+		std::cerr << "ERROR: the task tracer needs trace_steps >= 1 and trace_buffer_size >= 1" << std::endl;
+		abort();
+	}
 	if (opts().theta < octotiger::fmm::THETA_FLOOR) {
 		std::cerr << "theta " << theta << " is too small since Octo-Tiger was compiled for a minimum of " << octotiger::fmm::THETA_FLOOR << std::endl;
 		std::cerr << "Either increase theta or recompile with a new theta minimum using the cmake parameter OCTOTIGER_THETA_MINIMUM";
@@ -263,6 +319,27 @@ bool options::process_options(int argc, char *argv[]) {
 		SHOW(accretor_refine);
 		SHOW(amrbnd_order);
 		SHOW(bench);
+		SHOW(bench_warmup_steps);
+		SHOW(bench_steps);
+		SHOW(bench_json);
+		SHOW(trace_start_step);
+		SHOW(trace_steps);
+		SHOW(trace_buffer_size);
+		SHOW(trace_file);
+		SHOW(hw_counters);
+		SHOW(hw_counters_json);
+		SHOW(hw_fp_event);
+		SHOW(io_threads);
+		SHOW(telemetry_flush_interval);
+		SHOW(telemetry_buffer_rows);
+		SHOW(telemetry_binary);
+		SHOW(diagnostics_freq);
+		SHOW(conserved_sums_freq);
+		SHOW(timestep_all_reduce);
+		SHOW(timestep_lagged);
+		SHOW(timestep_lag_safety);
+		SHOW(roofline_peak_gflops);
+		SHOW(roofline_peak_gbs);
 		SHOW(cdisc_detect);
 		SHOW(cfl);
 		SHOW(clight_retard);
@@ -291,6 +368,8 @@ bool options::process_options(int argc, char *argv[]) {
 		SHOW(hydro);
 		SHOW(inflow_bc);
 		SHOW(input_file);
+		SHOW(ipr_table);
+		SHOW(ipr_table_polish);
 		SHOW(min_level);
 		SHOW(max_level);
 		SHOW(n_species);
@@ -302,6 +381,10 @@ bool options::process_options(int argc, char *argv[]) {
 		SHOW(rad_implicit);
 		SHOW(radiation);
 		SHOW(refinement_floor);
+		SHOW(derefinement_floor_ratio);
+		SHOW(refinement_min_lifetime);
+		SHOW(refinement_reuse_bounds);
+		SHOW(refinement_adaptive);
 		SHOW(reflect_bc);
 		SHOW(restart_filename);
 		SHOW(rotating_star_amr);
@@ -314,6 +397,9 @@ bool options::process_options(int argc, char *argv[]) {
 		SHOW(unigrid);
 		SHOW(v1309);
 		SHOW(idle_rates);
+		SHOW(load_balance_report);
+		SHOW(load_balance_weighted);
+		SHOW(load_imbalance_threshold);
 		SHOW(xscale);
 		SHOW(cuda_number_gpus);
 		SHOW(cuda_streams_per_gpu);
@@ -455,10 +541,17 @@ bool options::process_options(int argc, char *argv[]) {
         abort();
     }
     if (opts().eos == IPR) {
-        if ((opts().hydro_host_kernel_type != interaction_host_kernel_type::VC) && (opts().hydro_host_kernel_type != interaction_host_kernel_type::LEGACY)) {
+        if (opts().hydro_host_kernel_type == interaction_host_kernel_type::KOKKOS && !opts().ipr_table) {
+            std::cerr << std::endl << "ERROR: ";
+            std::cerr << "The ideal gas plus radiation (ipr) eos with KOKKOS host kernels requires the tabulated eos inversion!"  << std::endl
+            << " Either set ipr_table to on or choose LEGACY for hydro host kernel type!" << std::endl;
+            abort();
+        }
+        if ((opts().hydro_host_kernel_type != interaction_host_kernel_type::VC) && (opts().hydro_host_kernel_type != interaction_host_kernel_type::LEGACY) &&
+            (opts().hydro_host_kernel_type != interaction_host_kernel_type::KOKKOS)) {
             std::cerr << std::endl << "ERROR: ";
-            std::cerr << "The ideal gas plus radiation (ipr) eos is currently only supported with LEGACY host kernel types of the hydro solver!"  << std::endl
-            << " Choose either a LEGACY for hydro host kernel type or use a different eos!" << std::endl;
+            std::cerr << "The ideal gas plus radiation (ipr) eos is currently only supported with LEGACY and KOKKOS host kernel types of the hydro solver!"  << std::endl
+            << " Choose either a LEGACY or KOKKOS for hydro host kernel type or use a different eos!" << std::endl;
             abort();
         }
         if (opts().hydro_device_kernel_type != OFF) {
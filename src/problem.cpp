@@ -146,7 +146,7 @@ bool refine_test(integer level, integer max_level, real x, real y, real z, std::
 	if( grad_rho > 0.0 ) {
 		test_level--;
 	}
-	real den_floor = opts().refinement_floor;
+	real den_floor = refinement_density_floor();
 	for (integer this_test_level = test_level; this_test_level >= 1; --this_test_level) {
 		if (U[rho_i] > den_floor) {
 			rc = rc || (level < this_test_level);
@@ -171,7 +171,7 @@ bool refine_test(integer level, integer max_level, real x, real y, real z, std::
 bool refine_test_moving_star(integer level, integer max_level, real x, real y, real z, std::vector<real> const& U,
 		std::array<std::vector<real>, NDIM> const& dudx) {
 	bool rc = false;
-	real den_floor = opts().refinement_floor;
+	real den_floor = refinement_density_floor();
 	integer test_level = max_level;
 	if( x > 0.0 && opts().rotating_star_amr) {
 		test_level--;
@@ -211,6 +211,23 @@ bool refine_test_unigrid(integer level, integer max_level, real x, real y, real
 
 }
 
+namespace {
+thread_local bool derefinement_check = false;
+}
+
+real refinement_density_floor() {
+	return derefinement_check ? opts().derefinement_floor_ratio * opts().refinement_floor : opts().refinement_floor;
+}
+
+refinement_hysteresis_scope::refinement_hysteresis_scope(bool active) :
+		previous_(derefinement_check) {
+	derefinement_check = active;
+}
+
+refinement_hysteresis_scope::~refinement_hysteresis_scope() {
+	derefinement_check = previous_;
+}
+
 void set_refine_test(const refine_test_type& rt) {
 	if( opts().unigrid) {
 		refine_test_function = refine_test_unigrid;
@@ -4,105 +4,244 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include "octotiger/profiler.hpp"
-#include "octotiger/real.hpp"
+#include "octotiger/io/io_pool.hpp"
 
-//#include <hpx/util/high_resolution_clock.hpp>
+#include <hpx/include/actions.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/runtime.hpp>
+#include <hpx/modules/threading_base.hpp>
+#if HPX_VERSION_FULL > 0x010600
+// Can't find hpx::find_all_localities() in newer HPX versions without this header
+#include <hpx/modules/runtime_distributed.hpp>
+#endif
 
-//#include <cstdio>
 #include <cstring>
 #include <map>
 #include <memory>
-#include <atomic>
-#include <stack>
+#include <mutex>
 #include <string>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
-static thread_local std::stack<std::string> callstack;
-static thread_local real t = 0.0;
-std::unordered_map<std::string, std::shared_ptr<real> > map;
+namespace {
 
-std::string make_name(const char* f, int l) {
-	std::string str = f;
-	str += "+";
-	str += std::string(std::to_string(l));
-	return str;
-}
+struct region_info {
+	const char* func;
+	int line;
+};
+
+std::mutex registry_mtx;
+std::array<region_info, profiler_max_regions> regions;
+std::atomic<int> region_count(1);
 
-std::atomic<int>& lock() {
-	static std::atomic<int> a(0);
-	return a;
 }
 
-profiler_register::profiler_register(const char* func, int line) {
-	std::string str = make_name(func, line);
-	while (lock()++ != 0) {
-		--lock();}
-auto 	cntptr = std::make_shared < real > (0.0);
-	std::pair < std::string, std::shared_ptr<real> > entry;
-	entry.first = str;
-	entry.second = cntptr;
-	map.insert(entry);
-	--lock();}
-
-static/**/void accumulate() {
-	const real told = t;
-	t = hpx::chrono::high_resolution_clock::now() / 1e9;
-	if (!callstack.empty()) {
-		const std::string& str(callstack.top());
-		while (lock()++ != 0) {
-			--lock();
-			/* */
+// Counters of one OS thread. Only the owning thread writes them, so relaxed load/store pairs are
+// sufficient and the collecting thread merely reads a (slightly stale) consistent value per counter.
+struct profiler_thread_table {
+	struct counters {
+		std::atomic<std::uint64_t> inclusive;
+		std::atomic<std::uint64_t> exclusive;
+		std::atomic<std::uint64_t> calls;
+	};
+	std::array<counters, profiler_max_regions> c;
+
+	profiler_thread_table() {
+		for (auto& e : c) {
+			e.inclusive.store(0, std::memory_order_relaxed);
+			e.exclusive.store(0, std::memory_order_relaxed);
+			e.calls.store(0, std::memory_order_relaxed);
 		}
-		auto ptr = map[str];
-		--lock();
-		real dt = t - told;
-		(*ptr) += dt;
 	}
+
+	static void add(std::atomic<std::uint64_t>& a, std::uint64_t v) {
+		a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+	}
+};
+
+namespace {
+
+std::mutex tables_mtx;
+// Tables outlive their threads so that no sample is lost, their number is bounded by the number of
+// OS threads ever created
+std::vector<std::unique_ptr<profiler_thread_table>> tables;
+
+thread_local profiler_thread_table* thread_table = nullptr;
+
+profiler_thread_table& this_thread_table() {
+	if (thread_table == nullptr) {
+		std::lock_guard<std::mutex> lock(tables_mtx);
+		tables.emplace_back(new profiler_thread_table);
+		thread_table = tables.back().get();
+	}
+	return *thread_table;
+}
+
+std::string region_name(int id) {
+	if (id == 0) {
+		return "(other regions)";
+	}
+	return std::string(regions[id].func) + "+" + std::to_string(regions[id].line);
+}
+
+}
+
+int profiler_register(const char* func, int line) {
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	const int id = region_count.load(std::memory_order_relaxed);
+	if (id >= profiler_max_regions) {
+		return 0;
+	}
+	regions[id] = region_info { func, line };
+	region_count.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+// Scopes of one HPX thread nest strictly, so the chain of open scopes is a stack whose top is kept
+// in the thread data word of the HPX thread. Outside of HPX threads (startup, shutdown) there is no
+// chain and the exclusive time equals the inclusive time.
+profiler_scope::profiler_scope(int id) :
+		parent_(nullptr), child_(0), id_(id) {
+	const auto self = hpx::threads::get_self_id();
+	if (self != hpx::threads::invalid_thread_id) {
+		parent_ = reinterpret_cast<profiler_scope*>(hpx::threads::get_thread_data(self));
+		hpx::threads::set_thread_data(self, reinterpret_cast<std::size_t>(this));
+	}
+	start_ = hpx::chrono::high_resolution_clock::now();
 }
 
-static profiler_register prof_reg("OTHER", 0);
+// An HPX thread may be suspended inside a region and resumed on another OS thread, the time is
+// recorded in the table of the thread that closes the region
+profiler_scope::~profiler_scope() {
+	const std::uint64_t dt = hpx::chrono::high_resolution_clock::now() - start_;
+	const auto self = hpx::threads::get_self_id();
+	if (self != hpx::threads::invalid_thread_id) {
+		hpx::threads::set_thread_data(self, reinterpret_cast<std::size_t>(parent_));
+	}
+	if (parent_ != nullptr) {
+		parent_->child_ += dt;
+	}
+	auto& e = this_thread_table().c[id_];
+	profiler_thread_table::add(e.inclusive, dt);
+	profiler_thread_table::add(e.exclusive, dt > child_ ? dt - child_ : 0);
+	profiler_thread_table::add(e.calls, 1);
+}
 
-void profiler_enter(const char* func, int line) {
-	accumulate();
-	std::string str(make_name(func, line));
-	if (callstack.empty()) {
-		if (strncmp("OTHER", func, 5) != 0) {
-			profiler_enter("OTHER", 0);
+std::vector<profiler_entry> profiler_collect() {
+	const int n = region_count.load(std::memory_order_acquire);
+	std::vector<profiler_entry> entries(n);
+	for (int id = 0; id < n; id++) {
+		entries[id] = profiler_entry { region_name(id), 0.0, 0.0, 0 };
+	}
+	std::lock_guard<std::mutex> lock(tables_mtx);
+	for (const auto& t : tables) {
+		for (int id = 0; id < n; id++) {
+			auto& e = t->c[id];
+			entries[id].inclusive += e.inclusive.load(std::memory_order_relaxed) / 1e9;
+			entries[id].exclusive += e.exclusive.load(std::memory_order_relaxed) / 1e9;
+			entries[id].calls += e.calls.load(std::memory_order_relaxed);
+		}
+	}
+	std::vector<profiler_entry> used;
+	for (auto& e : entries) {
+		if (e.calls > 0) {
+			used.push_back(std::move(e));
 		}
 	}
-	callstack.push(str);
-	t = hpx::chrono::high_resolution_clock::now() / 1e9;
+	return used;
+}
+
+HPX_PLAIN_ACTION(profiler_collect, profiler_collect_action);
+
+namespace {
+
+void sort_entries(std::vector<profiler_entry>& entries) {
+	std::sort(entries.begin(), entries.end(), [](const profiler_entry& a, const profiler_entry& b) {
+		return a.exclusive > b.exclusive;
+	});
 }
-void profiler_exit() {
-	accumulate();
-	callstack.pop();
-	t = hpx::chrono::high_resolution_clock::now() / 1e9;
+
+void write_table(FILE* fp, const std::vector<profiler_entry>& entries) {
+	// Seconds summed over all threads, exclusive times add up to the total without double counting
+	double ttot = 0.0;
+	for (const auto& e : entries) {
+		ttot += e.exclusive;
+	}
+	fprintf(fp, "%f total seconds (summed over all threads)\n", ttot);
+	fprintf(fp, "%4s %60s %12s %12s %8s %14s %12s\n", "rank", "region", "exclusive", "inclusive", "% excl", "calls",
+			"per call");
+	int r = 1;
+	for (const auto& e : entries) {
+		fprintf(fp, "%4i %60s %12.4f %12.4f %8.2f %14llu %12.4e\n", r++, e.name.c_str(), e.exclusive, e.inclusive,
+				ttot > 0.0 ? e.exclusive * 100.0 / ttot : 0.0, static_cast<unsigned long long>(e.calls),
+				e.calls > 0 ? e.inclusive / e.calls : 0.0);
+	}
+	fprintf(fp, "\n");
 }
 
-void profiler_output(FILE* _fp) {
-#ifndef PROFILE_OFF
-	std::map < real, std::string > ranks;
-	real ttot = 0.0;
-	for (auto i = map.begin(); i != map.end(); ++i) {
-		real& tm = *(i->second);
-		ranks[tm] = i->first;
-		ttot += tm;
-		tm = 0.0;
-	}
-	FILE* fps[2];
-	fps[0] = _fp;
-	fps[1] = stdout;
-	for (int f = 0; f != 2; f++) {
-		int r = 1;
-		FILE* fp = fps[f];
-		fprintf(fp, "%f total seconds\n", ttot);
-		for (auto i = ranks.end(); i != ranks.begin(); r <= 10) {
-			i--;
-			fprintf(fp, "%4i %60s %8.2f %% %8.2f\n", r++, i->second.c_str(), i->first * 100.0 / ttot, i->first);
+void write_json(FILE* fp, const std::vector<profiler_entry>& entries, std::size_t localities) {
+	fprintf(fp, "{\n  \"localities\": %zu,\n  \"regions\": [", localities);
+	for (std::size_t i = 0; i < entries.size(); i++) {
+		const auto& e = entries[i];
+		std::string name;
+		for (const char ch : e.name) {
+			if (ch == '"' || ch == '\\') {
+				name += '\\';
+			}
+			name += ch;
 		}
-		fprintf(fp, "\n");
+		fprintf(fp, "%s\n    {\"name\": \"%s\", \"exclusive\": %.9e, \"inclusive\": %.9e, \"calls\": %llu}",
+				i ? "," : "", name.c_str(), e.exclusive, e.inclusive, static_cast<unsigned long long>(e.calls));
 	}
-#endif
+	fprintf(fp, "\n  ]\n}\n");
 }
 
+}
+
+void profiler_output(FILE* fp) {
+	auto entries = profiler_collect();
+	sort_entries(entries);
+	write_table(fp, entries);
+	write_table(stdout, entries);
+}
+
+void profiler_report(const std::string& txt_file, const std::string& json_file) {
+	const std::vector<hpx::id_type> localities = hpx::find_all_localities();
+	std::vector<hpx::future<std::vector<profiler_entry>>> futs;
+	futs.reserve(localities.size());
+	for (const auto& id : localities) {
+		futs.push_back(hpx::async<profiler_collect_action>(id));
+	}
+	// Region ids are assigned in order of first use and differ between localities, merge by name
+	std::map<std::string, profiler_entry> merged;
+	for (auto& f : futs) {
+		for (auto& e : f.get()) {
+			auto i = merged.find(e.name);
+			if (i == merged.end()) {
+				merged.emplace(e.name, std::move(e));
+			} else {
+				i->second.inclusive += e.inclusive;
+				i->second.exclusive += e.exclusive;
+				i->second.calls += e.calls;
+			}
+		}
+	}
+	std::vector<profiler_entry> entries;
+	entries.reserve(merged.size());
+	for (auto& e : merged) {
+		entries.push_back(std::move(e.second));
+	}
+	sort_entries(entries);
+
+	write_table(stdout, entries);
+	io::submit([&]() {
+		if (FILE* fp = fopen(txt_file.c_str(), "wt")) {
+			write_table(fp, entries);
+			fclose(fp);
+		}
+		if (FILE* fp = fopen(json_file.c_str(), "wt")) {
+			write_json(fp, entries, localities.size());
+			fclose(fp);
+		}
+	}).get();
+}
@@ -4,8 +4,10 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 
+#include "octotiger/comm_counters.hpp"
 #include "octotiger/defs.hpp"
 #include "octotiger/grid.hpp"
+#include "octotiger/kernel_counters.hpp"
 #include "octotiger/node_server.hpp"
 #include "octotiger/options.hpp"
 #include "octotiger/radiation/implicit.hpp"
@@ -121,6 +123,7 @@ using send_rad_flux_correct_action_type = node_server::send_rad_flux_correct_act
 HPX_REGISTER_ACTION (send_rad_flux_correct_action_type);
 
 void node_client::send_rad_flux_correct(std::vector<real> &&data, const geo::face &face, const geo::octant &ci) const {
+	comm_counters::record(comm_counters::rad_flux_correct, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_rad_flux_correct_action>(get_unmanaged_gid(), std::move(data), face, ci);
 }
 
@@ -130,6 +133,7 @@ void node_server::recv_rad_flux_correct(std::vector<real> &&data, const geo::fac
 }
 
 void node_client::send_rad_boundary(std::vector<real> &&data, const geo::direction &dir, std::size_t cycle) const {
+	comm_counters::record(comm_counters::rad_boundary, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_rad_boundary_action>(get_gid(), std::move(data), dir, cycle);
 }
 
@@ -148,11 +152,12 @@ void node_server::recv_rad_children(std::vector<real> &&data, const geo::octant
 }
 
 void node_client::send_rad_children(std::vector<real> &&data, const geo::octant &ci, std::size_t cycle) const {
+	comm_counters::record(comm_counters::rad_children, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_rad_children_action>(get_unmanaged_gid(), std::move(data), ci, cycle);
 }
 
-void rad_grid::rad_imp(std::vector<real> &egas, std::vector<real> &tau, std::vector<real> &sx, std::vector<real> &sy, std::vector<real> &sz,
-		const std::vector<real> &rho, real dt) {
+void rad_grid::rad_imp(field_span<real> egas, field_span<real> tau, field_span<real> sx, field_span<real> sy, field_span<real> sz,
+		field_span<const real> rho, real dt) {
 	PROFILE()
 	;
 	const integer d = H_BW - RAD_BW;
@@ -222,7 +227,7 @@ real rad_grid::hydro_signal_speed(const std::vector<real> &egas, const std::vect
 	return SQRT(a);
 }
 
-void rad_grid::compute_mmw(const std::vector<std::vector<safe_real>> &U) {
+void rad_grid::compute_mmw(field_view<const safe_real> U) {
 	mmw.resize(RAD_N3);
 	X_spc.resize(RAD_N3);
 	Z_spc.resize(RAD_N3);
@@ -262,20 +267,24 @@ void node_server::compute_radiation(real dt, real omega) {
 	integer nsteps = std::max(int(ns), 1);
 
 	const real this_dt = dt * INVERSE(real(nsteps));
-	auto &egas = grid_ptr->get_field(egas_i);
-	const auto &rho = grid_ptr->get_field(rho_i);
-	auto &tau = grid_ptr->get_field(tau_i);
-	auto &sx = grid_ptr->get_field(sx_i);
-	auto &sy = grid_ptr->get_field(sy_i);
-	auto &sz = grid_ptr->get_field(sz_i);
+	const auto egas = grid_ptr->get_field(egas_i);
+	const field_span<const real> rho = grid_ptr->get_field(rho_i);
+	const auto tau = grid_ptr->get_field(tau_i);
+	const auto sx = grid_ptr->get_field(sx_i);
+	const auto sy = grid_ptr->get_field(sy_i);
+	const auto sz = grid_ptr->get_field(sz_i);
 	rad_grid_ptr->set_X(grid_ptr->get_X());
 
 //	if (my_location.level() == 0) {
 //		print("Explicit\n");
 //	}
 	if (opts().rad_implicit) {
+		kernel_counters::scope kc(kernel_counters::radiation, kernel_counters::radiation_implicit, []() {
+			return kernel_counters::radiation_cost(kernel_counters::radiation_implicit);
+		});
 		rgrid->rad_imp(egas, tau, sx, sy, sz, rho, 0.5 * dt);
 	}
+	timings::scope ts(timings_, timings::time_radiation_substeps);
 	for (integer i = 0; i != nsteps; ++i) {
 		//	rgrid->sanity_check();
 		if (my_location.level() == 0) {
@@ -287,7 +296,12 @@ void node_server::compute_radiation(real dt, real omega) {
 		const double beta[3] = { 1.0, 0.25, 2.0 / 3.0 };
 		for (int rk = 0; rk < 3; rk++) {
 			all_rad_bounds();
-			rgrid->compute_flux(omega);
+			{
+				kernel_counters::scope kc(kernel_counters::radiation, kernel_counters::radiation_explicit, []() {
+					return kernel_counters::radiation_cost(kernel_counters::radiation_explicit);
+				});
+				rgrid->compute_flux(omega);
+			}
 //			if( my_location.level() == 0 ) print( "\nbounds 10\n");
 			GET(exchange_rad_flux_corrections());
 //			if( my_location.level() == 0 ) print( "\nbounds 11\n");
@@ -296,6 +310,9 @@ void node_server::compute_radiation(real dt, real omega) {
 
 	}
 	if (opts().rad_implicit) {
+		kernel_counters::scope kc(kernel_counters::radiation, kernel_counters::radiation_implicit, []() {
+			return kernel_counters::radiation_cost(kernel_counters::radiation_implicit);
+		});
 		rgrid->rad_imp(egas, tau, sx, sy, sz, rho, 0.5 * dt);
 	}
 //	rgrid->sanity_check();
@@ -673,7 +690,7 @@ void node_server::collect_radiation_bounds() {
 
 }
 
-void rad_grid::initialize_erad(const std::vector<safe_real> rho, const std::vector<safe_real> tau) {
+void rad_grid::initialize_erad(field_span<const safe_real> rho, field_span<const safe_real> tau) {
 	const real fgamma = grid::get_fgamma();
 	for (integer xi = 0; xi != RAD_NX; ++xi) {
 		for (integer yi = 0; yi != RAD_NX; ++yi) {
@@ -1091,6 +1108,7 @@ void node_server::recv_rad_amr_boundary(std::vector<real>&& bdata, const geo::di
 }
 
 void node_client::send_rad_amr_boundary(std::vector<real>&& data, const geo::direction& dir, std::size_t cycle) const {
+	comm_counters::record(comm_counters::rad_amr_boundary, is_local(), comm_counters::payload_bytes(data));
 	hpx::apply<typename node_server::send_rad_amr_boundary_action>(get_unmanaged_gid(), std::move(data), dir, cycle);
 }
 
@@ -0,0 +1,165 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/telemetry.hpp"
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/options.hpp"
+#include "octotiger/print.hpp"
+
+#include <hpx/include/lcos.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace telemetry {
+
+namespace {
+
+struct stream_format {
+	const char* name;
+	const char* real_fmt;
+	// Columns printed as integers
+	std::vector<std::size_t> integer_columns;
+	bool trailing_space;
+};
+
+const stream_format formats[stream_count] = { //
+		{ "step", "%e", { 0, 13, 14, 15, 16 }, false }, //
+		{ "binary", "%13e", { }, true }, //
+		{ "sums", "%.13e", { }, true }, //
+		{ "conserved", "%.13e", { 0 }, true } };
+
+struct stream_buffer {
+	std::mutex mtx;
+	std::string text;
+	// Row major, converted to column major when written
+	std::vector<double> values;
+	std::size_t rows = 0;
+	std::size_t columns = 0;
+	std::chrono::steady_clock::time_point last_flush = std::chrono::steady_clock::now();
+	// Completes when the last block handed to the I/O pool is written, invalid before the first one
+	hpx::shared_future<void> written;
+};
+
+stream_buffer buffers[stream_count];
+
+void append_text(std::string& text, const stream_format& f, const std::vector<double>& row) {
+	char tmp[64];
+	for (std::size_t i = 0; i < row.size(); i++) {
+		if (i) {
+			text += ' ';
+		}
+		if (std::find(f.integer_columns.begin(), f.integer_columns.end(), i) != f.integer_columns.end()) {
+			snprintf(tmp, sizeof(tmp), "%lli", static_cast<long long>(row[i]));
+		} else {
+			snprintf(tmp, sizeof(tmp), f.real_fmt, row[i]);
+		}
+		text += tmp;
+	}
+	if (f.trailing_space) {
+		text += ' ';
+	}
+	text += '\n';
+}
+
+void write_block(stream_type s, const std::string& text, const std::vector<double>& values, std::size_t rows,
+		std::size_t columns) {
+	const std::string base = opts().data_dir + formats[s].name;
+	FILE* fp = fopen((base + ".dat").c_str(), "at");
+	if (fp == nullptr) {
+		print("Unable to open %s.dat for writing %s\n", base.c_str(), std::strerror(errno));
+	} else {
+		fwrite(text.data(), sizeof(char), text.size(), fp);
+		fclose(fp);
+	}
+	if (!opts().telemetry_binary) {
+		return;
+	}
+	fp = fopen((base + ".bin").c_str(), "ab");
+	if (fp == nullptr) {
+		print("Unable to open %s.bin for writing %s\n", base.c_str(), std::strerror(errno));
+		return;
+	}
+	if (ftell(fp) == 0) {
+		fwrite("OCTOTLM1", sizeof(char), 8, fp);
+	}
+	const std::uint64_t header[2] = { rows, columns };
+	fwrite(header, sizeof(std::uint64_t), 2, fp);
+	std::vector<double> column(rows);
+	for (std::size_t c = 0; c < columns; c++) {
+		for (std::size_t r = 0; r < rows; r++) {
+			column[r] = values[r * columns + c];
+		}
+		fwrite(column.data(), sizeof(double), rows, fp);
+	}
+	fclose(fp);
+}
+
+// Hands the pending rows of s to the I/O pool, b.mtx must be held
+void flush_locked(stream_type s, stream_buffer& b) {
+	b.last_flush = std::chrono::steady_clock::now();
+	if (b.rows == 0) {
+		return;
+	}
+	auto text = std::make_shared<std::string>();
+	auto values = std::make_shared<std::vector<double>>();
+	text->swap(b.text);
+	values->swap(b.values);
+	const auto rows = b.rows;
+	const auto columns = b.columns;
+	b.rows = 0;
+	if (!b.written.valid()) {
+		b.written = hpx::make_ready_future();
+	}
+	b.written = b.written.then([s, text, values, rows, columns](hpx::shared_future<void>) {
+		io::submit([&]() {
+			write_block(s, *text, *values, rows, columns);
+		}).get();
+	});
+}
+
+}
+
+void record(stream_type s, std::vector<double> row) {
+	auto& b = buffers[s];
+	std::lock_guard<std::mutex> lock(b.mtx);
+	if (b.rows != 0 && row.size() != b.columns) {
+		flush_locked(s, b);
+	}
+	b.columns = row.size();
+	append_text(b.text, formats[s], row);
+	b.values.insert(b.values.end(), row.begin(), row.end());
+	b.rows++;
+	const std::chrono::duration<double> since_flush = std::chrono::steady_clock::now() - b.last_flush;
+	if (b.rows >= std::size_t(std::max(opts().telemetry_buffer_rows, integer(1)))
+			|| since_flush.count() >= opts().telemetry_flush_interval) {
+		flush_locked(s, b);
+	}
+}
+
+void flush() {
+	for (int s = 0; s < stream_count; s++) {
+		hpx::shared_future<void> written;
+		{
+			auto& b = buffers[s];
+			std::lock_guard<std::mutex> lock(b.mtx);
+			flush_locked(stream_type(s), b);
+			written = b.written;
+		}
+		if (written.valid()) {
+			written.get();
+		}
+	}
+}
+
+}
@@ -0,0 +1,176 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/timestep_reduce.hpp"
+#include "octotiger/future.hpp"
+#include "octotiger/node_registry.hpp"
+#include "octotiger/options.hpp"
+
+#include <hpx/collectives/all_reduce.hpp>
+#include <hpx/collectives/create_communicator.hpp>
+#include <hpx/include/actions.hpp>
+#include <hpx/include/runtime.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace timestep_reduce {
+
+namespace {
+
+struct reduction_state {
+	std::mutex mtx;
+	// Communicator of the localities owning nodes, unused when this is the only one
+	hpx::collectives::communicator comm;
+	std::size_t sites = 1;
+	std::size_t site = 0;
+	std::size_t generation = 0;
+	// Contributions to the current reduction and their minimum
+	std::size_t pending = 0;
+	std::size_t expected = 0;
+	timestep_t local_min;
+	std::shared_ptr<hpx::lcos::local::promise<timestep_t>> promise;
+	hpx::shared_future<timestep_t> result;
+	// Result of the last completed reduction, zero before the first one
+	real last_dt = 0.0;
+};
+
+reduction_state state;
+
+// Root only: which localities took part in the last setup
+std::vector<bool> participants;
+std::size_t epoch = 0;
+
+timestep_t min_timestep(const timestep_t& a, const timestep_t& b) {
+	return b.dt < a.dt ? b : a;
+}
+
+void complete(hpx::lcos::local::promise<timestep_t>& promise, timestep_t dt) {
+	{
+		std::lock_guard<std::mutex> lock(state.mtx);
+		state.last_dt = dt.dt;
+	}
+	promise.set_value(std::move(dt));
+}
+
+}
+
+std::size_t begin_block(real last_dt) {
+	std::lock_guard<std::mutex> lock(state.mtx);
+	state.last_dt = last_dt;
+	return node_registry::size();
+}
+
+void setup(std::size_t new_epoch, std::size_t sites, std::size_t site) {
+	std::lock_guard<std::mutex> lock(state.mtx);
+	state.sites = sites;
+	state.site = site;
+	state.generation = 0;
+	if (sites > 1) {
+		const std::string basename = "/octotiger/timestep_reduce/" + std::to_string(new_epoch);
+		state.comm = hpx::collectives::create_communicator(basename.c_str(), hpx::collectives::num_sites_arg(sites),
+				hpx::collectives::this_site_arg(site));
+	} else {
+		state.comm = hpx::collectives::communicator();
+	}
+}
+
+}
+
+HPX_PLAIN_ACTION(timestep_reduce::begin_block, timestep_reduce_begin_block_action);
+HPX_PLAIN_ACTION(timestep_reduce::setup, timestep_reduce_setup_action);
+
+namespace timestep_reduce {
+
+void prepare() {
+	const auto& localities = options::all_localities;
+	real last_dt;
+	{
+		std::lock_guard<std::mutex> lock(state.mtx);
+		last_dt = state.last_dt;
+	}
+	// The root locality always owns the root node, so its last result is the current one. Localities
+	// that did not own nodes during the previous block get it for the lagged timestep.
+	std::vector<hpx::future<std::size_t>> futs;
+	futs.reserve(localities.size());
+	for (const auto& id : localities) {
+		futs.push_back(hpx::async<timestep_reduce_begin_block_action>(id, last_dt));
+	}
+	std::vector<bool> owners(localities.size());
+	for (std::size_t l = 0; l < localities.size(); l++) {
+		owners[l] = GET(futs[l]) > 0;
+	}
+	if (owners == participants) {
+		return;
+	}
+	participants = std::move(owners);
+	epoch++;
+	std::size_t sites = 0;
+	for (bool p : participants) {
+		sites += p ? 1 : 0;
+	}
+	std::vector<hpx::future<void>> sfuts;
+	std::size_t site = 0;
+	for (std::size_t l = 0; l < localities.size(); l++) {
+		if (participants[l]) {
+			sfuts.push_back(hpx::async<timestep_reduce_setup_action>(localities[l], epoch, sites, site++));
+		}
+	}
+	for (auto& f : sfuts) {
+		GET(f);
+	}
+}
+
+hpx::shared_future<timestep_t> contribute(const timestep_t& dt) {
+	std::shared_ptr<hpx::lcos::local::promise<timestep_t>> promise;
+	hpx::shared_future<timestep_t> result;
+	timestep_t local_min;
+	hpx::collectives::communicator comm;
+	std::size_t sites, site, generation;
+	{
+		std::lock_guard<std::mutex> lock(state.mtx);
+		if (state.pending == 0) {
+			// The tree does not change during a step, so every local node contributes once
+			state.expected = node_registry::size();
+			state.local_min = dt;
+			state.promise = std::make_shared<hpx::lcos::local::promise<timestep_t>>();
+			state.result = state.promise->get_future().share();
+		} else {
+			state.local_min = min_timestep(state.local_min, dt);
+		}
+		result = state.result;
+		if (++state.pending != state.expected) {
+			return result;
+		}
+		state.pending = 0;
+		promise = std::move(state.promise);
+		local_min = state.local_min;
+		comm = state.comm;
+		sites = state.sites;
+		site = state.site;
+		generation = ++state.generation;
+	}
+	// Last local contribution, outside of the lock since setting the value may run continuations
+	if (sites == 1) {
+		complete(*promise, std::move(local_min));
+	} else {
+		hpx::collectives::all_reduce(comm, std::move(local_min), &min_timestep, hpx::collectives::this_site_arg(site),
+				hpx::collectives::generation_arg(generation)).then(hpx::launch::sync, [promise](hpx::future<timestep_t> f) {
+			complete(*promise, GET(f));
+		});
+	}
+	return result;
+}
+
+real lagged_dt() {
+	std::lock_guard<std::mutex> lock(state.mtx);
+	return opts().timestep_lag_safety * state.last_dt;
+}
+
+}
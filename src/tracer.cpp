@@ -0,0 +1,173 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "octotiger/tracer.hpp"
+#include "octotiger/io/io_pool.hpp"
+#include "octotiger/options.hpp"
+#include "octotiger/print.hpp"
+
+#include <hpx/include/actions.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/runtime.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+std::atomic<bool> tracer_active(false);
+
+namespace {
+
+struct raw_event {
+	const char* name;
+	std::uint64_t begin;
+	std::uint64_t end;
+	std::uint32_t worker;
+	node_location::node_id node;
+};
+
+// Ring buffer of one OS thread, only the owning thread writes to it. It is read after tracing
+// has been switched off, events of regions that end later are dropped.
+struct trace_buffer {
+	std::vector<raw_event> events;
+	std::atomic<std::uint64_t> count;
+
+	explicit trace_buffer(std::size_t capacity) :
+			events(capacity), count(0) {
+	}
+
+	void push(const raw_event& e) {
+		const auto n = count.load(std::memory_order_relaxed);
+		events[n % events.size()] = e;
+		count.store(n + 1, std::memory_order_release);
+	}
+};
+
+std::mutex buffers_mtx;
+std::vector<std::unique_ptr<trace_buffer>> buffers;
+
+thread_local trace_buffer* thread_buffer = nullptr;
+
+trace_buffer& this_thread_buffer() {
+	if (thread_buffer == nullptr) {
+		std::lock_guard<std::mutex> lock(buffers_mtx);
+		buffers.emplace_back(new trace_buffer(std::max(opts().trace_buffer_size, integer(1))));
+		thread_buffer = buffers.back().get();
+	}
+	return *thread_buffer;
+}
+
+std::uint64_t now() {
+	// The system clock rather than a steady one, so the time lines of different nodes line up
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+void trace_scope::begin() {
+	begin_ = now();
+	worker_ = hpx::get_worker_thread_num();
+}
+
+void trace_scope::end() {
+	if (tracer_active.load(std::memory_order_relaxed)) {
+		this_thread_buffer().push(raw_event { name_, begin_, now(), worker_, node_ });
+	}
+}
+
+void tracer_enable(bool on) {
+	if (on) {
+		std::lock_guard<std::mutex> lock(buffers_mtx);
+		for (auto& b : buffers) {
+			b->count.store(0, std::memory_order_relaxed);
+		}
+	}
+	tracer_active.store(on);
+}
+
+std::vector<trace_event> tracer_collect() {
+	std::vector<trace_event> rc;
+	std::size_t lost = 0;
+	std::lock_guard<std::mutex> lock(buffers_mtx);
+	for (const auto& b : buffers) {
+		const auto n = b->count.load(std::memory_order_acquire);
+		const auto cap = b->events.size();
+		const auto first = n > cap ? n - cap : 0;
+		lost += first;
+		for (auto i = first; i < n; i++) {
+			const auto& e = b->events[i % cap];
+			rc.push_back(trace_event { e.name, e.begin, e.end, e.worker, e.node });
+		}
+	}
+	if (lost) {
+		print("Tracer: %lli events overwritten on locality %i, increase trace_buffer_size\n", static_cast<long long>(lost),
+				int(hpx::get_locality_id()));
+	}
+	std::sort(rc.begin(), rc.end(), [](const trace_event& a, const trace_event& b) {
+		return a.begin < b.begin;
+	});
+	return rc;
+}
+
+HPX_PLAIN_ACTION(tracer_enable, tracer_enable_action);
+HPX_PLAIN_ACTION(tracer_collect, tracer_collect_action);
+
+void tracer_enable_all(bool on) {
+	std::vector<hpx::future<void>> futs;
+	futs.reserve(options::all_localities.size());
+	for (const auto& id : options::all_localities) {
+		futs.push_back(hpx::async<tracer_enable_action>(id, on));
+	}
+	for (auto& f : futs) {
+		f.get();
+	}
+}
+
+void tracer_write_all(const std::string& filename) {
+	tracer_enable_all(false);
+	std::vector<hpx::future<std::vector<trace_event>>> futs;
+	futs.reserve(options::all_localities.size());
+	for (const auto& id : options::all_localities) {
+		futs.push_back(hpx::async<tracer_collect_action>(id));
+	}
+	std::vector<std::vector<trace_event>> events;
+	std::uint64_t t0 = std::numeric_limits<std::uint64_t>::max();
+	for (auto& f : futs) {
+		events.push_back(f.get());
+		if (!events.back().empty()) {
+			t0 = std::min(t0, events.back().front().begin);
+		}
+	}
+
+	io::submit([&]() {
+		FILE* fp = fopen(filename.c_str(), "wt");
+		if (fp == nullptr) {
+			print("Unable to open %s for writing\n", filename.c_str());
+			return;
+		}
+		// Chrome trace-event format: one process per locality, one thread per worker, times in us
+		std::size_t count = 0;
+		fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+		for (std::size_t l = 0; l < events.size(); l++) {
+			fprintf(fp, "%s\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %i, \"args\": {\"name\": \"locality %i\"}}",
+					l ? "," : "", int(l), int(l));
+			for (const auto& e : events[l]) {
+				fprintf(fp, ",\n{\"name\": \"%s\", \"cat\": \"level %i\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %i, "
+						"\"tid\": %u, \"args\": {\"node\": \"%s\"}}", e.name.c_str(), int(node_location(e.node).level()),
+						(e.begin - t0) / 1e3, (e.end - e.begin) / 1e3, int(l), unsigned(e.worker),
+						node_location(e.node).to_str().c_str());
+				count++;
+			}
+		}
+		fprintf(fp, "\n]}\n");
+		fclose(fp);
+		print("%lli trace events written to %s\n", static_cast<long long>(count), filename.c_str());
+	}).get();
+}
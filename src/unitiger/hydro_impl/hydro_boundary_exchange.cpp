@@ -32,16 +32,9 @@ void init_aggregation_pool(void) {
 
 __host__ void launch_complete_hydro_amr_boundary_cuda(double dx, bool
     energy_only,
-    const std::vector<std::vector<real>>& Ushad, const std::vector<int>& is_coarse,
-    const std::array<double, NDIM>& xmin, std::vector<std::vector<real>>& U) {
-    bool early_exit = true;
-    for (int i = 0; i < HS_N3; i++) {
-        if (early_exit && is_coarse[i]) {
-          early_exit = false;
-          break;
-        }
-    }
-    if (early_exit)
+    const std::vector<std::vector<real>>& Ushad, const coarse_mask& is_coarse,
+    const std::array<double, NDIM>& xmin, field_view<real> U) {
+    if (is_coarse.none())
       return;
     // Init local kernel pool if not done already
     hpx::lcos::local::call_once(init_pool_flag, init_aggregation_pool);
@@ -126,8 +119,8 @@ __host__ void launch_complete_hydro_amr_boundary_cuda(double dx, bool
             number_slices * (opts().n_fields * HS_N3) * sizeof(double),
             cudaMemcpyHostToDevice);
 
-        for (int i = 0; i < HS_N3; i++) {
-            coarse[i + slice_id * HS_N3] = is_coarse[i];
+        for (const int i : is_coarse.cells()) {
+            coarse[i + slice_id * HS_N3] = 1;
         }
         exec_slice.post(cudaMemcpyAsync, device_coarse.device_side_buffer, coarse.data(),
             number_slices * (HS_N3) * sizeof(int), cudaMemcpyHostToDevice);
@@ -242,16 +235,14 @@ __host__ void launch_complete_hydro_amr_boundary_cuda(double dx, bool
 #endif
 
 void complete_hydro_amr_boundary_cpu(const double dx, const bool energy_only,
-    const std::vector<std::vector<real>>& Ushad, const std::vector<int>& is_coarse,
-    const std::array<double, NDIM>& xmin, std::vector<std::vector<double>>& U) {
+    const std::vector<std::vector<real>>& Ushad, const coarse_mask& is_coarse,
+    const std::array<double, NDIM>& xmin, field_view<real> U) {
     // std::cout << "Calling hydro cpu version!" << std::endl;
 
     // std::vector<double, recycler::aggressive_recycle_aligned<double, 32>> unified_u(
     //     opts().n_fields * H_N3);
     std::vector<double, recycler::aggressive_recycle_aligned<double, 32>> unified_ushad(
         opts().n_fields * HS_N3);
-    // Create non-atomic copy
-    std::vector<int, recycler::aggressive_recycle_aligned<int, 32>> coarse(HS_N3);
 
     for (int f = 0; f < opts().n_fields; f++) {
         if (!energy_only || f == egas_i) {
@@ -260,49 +251,46 @@ void complete_hydro_amr_boundary_cpu(const double dx, const bool energy_only,
         }
     }
 
-    for (int i = 0; i < HS_N3; i++) {
-        coarse[i] = is_coarse[i];
-    }
     // constexpr int field_offset = HS_N3 * 8;
 
     // Phase 1: From UShad to Uf
     constexpr int uf_max = OCTOTIGER_MAX_NUMBER_FIELDS;
     double uf_local[uf_max * 8];
-    for (int i0 = 1; i0 < HS_NX - 1; i0++) {
-        for (int j0 = 1; j0 < HS_NX - 1; j0++) {
-            for (int k0 = 1; k0 < HS_NX - 1; k0++) {
-                const int iii0 = i0 * HS_DNX + j0 * HS_DNY + k0 * HS_DNZ;
-                if (coarse[iii0]) {
-                    complete_hydro_amr_boundary_inner_loop<double>(dx, energy_only,
-                        unified_ushad.data(), coarse.data(), xmin.data(), i0, j0,
-                        k0, opts().n_fields, true, 0, iii0, uf_local);
-                    int i = 2 * i0 - H_BW;
-                    int j = 2 * j0 - H_BW;
-                    int k = 2 * k0 - H_BW;
-                    int ir = 0;
-                    if (i < 0)
-                        ir = 1;
-                    for (; ir < 2 && i + ir < H_NX; ir++) {
-                        int jr = 0;
-                        if (j < 0)
-                            jr = 1;
-                        for (; jr < 2 && j + jr < H_NX; jr++) {
-                            int kr = 0;
-                            if (k < 0)
-                                kr = 1;
-                            for (; kr < 2 && k + kr < H_NX; kr++) {
-                                const int iiir = hindex(i + ir, j + jr, k + kr);
-                                const int oct_index = ir * 4 + jr * 2 + kr;
-                                for (int f = 0; f < opts().n_fields; f++) {
-                                    if (!energy_only || f == egas_i) {
-                                        U[f][iiir] =
-                                            uf_local[f * 8 + oct_index];
-                                    }
-                                }
-                            }
+    // Only visit the cells in the coarse list, the outermost shadow layer is never prolonged
+    for (const int iii0 : is_coarse.cells()) {
+        if (!is_interior_shadow_cell(iii0)) {
+            continue;
+        }
+        const int i0 = iii0 / HS_DNX;
+        const int j0 = (iii0 / HS_DNY) % HS_NX;
+        const int k0 = iii0 % HS_NX;
+        complete_hydro_amr_boundary_inner_loop<double>(dx, energy_only,
+            unified_ushad.data(), nullptr, xmin.data(), i0, j0,
+            k0, opts().n_fields, true, 0, iii0, uf_local);
+        int i = 2 * i0 - H_BW;
+        int j = 2 * j0 - H_BW;
+        int k = 2 * k0 - H_BW;
+        int ir = 0;
+        if (i < 0)
+            ir = 1;
+        for (; ir < 2 && i + ir < H_NX; ir++) {
+            int jr = 0;
+            if (j < 0)
+                jr = 1;
+            for (; jr < 2 && j + jr < H_NX; jr++) {
+                int kr = 0;
+                if (k < 0)
+                    kr = 1;
+                for (; kr < 2 && k + kr < H_NX; kr++) {
+                    const int iiir = hindex(i + ir, j + jr, k + kr);
+                    const int oct_index = ir * 4 + jr * 2 + kr;
+                    for (int f = 0; f < opts().n_fields; f++) {
+                        if (!energy_only || f == egas_i) {
+                            U[f][iiir] =
+                                uf_local[f * 8 + oct_index];
                         }
                     }
-                } 
+                }
             }
         }
     }
@@ -18,8 +18,8 @@
 #include "octotiger/util/vec_vc_wrapper.hpp"
 
 void complete_hydro_amr_boundary_vc(const double dx, const bool energy_only,
-    const std::vector<std::vector<real>>& Ushad, const std::vector<int>& is_coarse,
-    const std::array<double, NDIM>& xmin, std::vector<std::vector<double>>& U) {
+    const std::vector<std::vector<real>>& Ushad, const coarse_mask& is_coarse,
+    const std::array<double, NDIM>& xmin, field_view<real> U) {
 
     std::vector<double, recycler::aggressive_recycle_aligned<double, 32>> unified_u(
         opts().n_fields * H_N3);
@@ -44,7 +44,7 @@ void complete_hydro_amr_boundary_vc(const double dx, const bool energy_only,
             for (int k0 = 1; k0 < HS_NX - 1; k0 += vc_type::size()) {
                 const int iii0 = i0 * HS_DNX + j0 * HS_DNY + k0 * HS_DNZ;
                 for (int mi = 0; mi < vc_type::size(); mi++)
-                    mask_coarse[mi] = is_coarse[mi + iii0];
+                    mask_coarse[mi] = is_coarse.test(mi + iii0);
                 const int border = HS_NX - 1 - k0;
                 const mask_type mask1 = (zindices < border);
                 const mask_type mask2(mask_coarse);
@@ -52,11 +52,11 @@ void complete_hydro_amr_boundary_vc(const double dx, const bool energy_only,
                 if (Vc::none_of(mask))
                     continue;
                 complete_hydro_amr_boundary_inner_loop<vc_type>(dx, energy_only,
-                    unified_ushad.data(), is_coarse.data(), xmin.data(), i0, j0, k0,
+                    unified_ushad.data(), nullptr, xmin.data(), i0, j0, k0,
                     opts().n_fields, mask, zindices, iii0, uf_local);
 
                 for (int mi = 0; mi < vc_type::size(); mi++) {
-                if (is_coarse[iii0 + mi] && k0 + mi < HS_NX -1) {
+                if (mask_coarse[mi] && k0 + mi < HS_NX -1) {
                     const int i = 2 * i0 - H_BW ;
                     const int j = 2 * j0 - H_BW ;
                     const int k = 2 * (k0 + mi) - H_BW ;
@@ -96,9 +96,9 @@ __host__ const bool* get_gpu_masks(void) {
 // Output F
 // TODO remove obsolete executor
 timestep_t launch_hydro_cuda_kernels(const hydro_computer<NDIM, INX, physics<NDIM>>& hydro,
-    const std::vector<std::vector<safe_real>>& U, const std::vector<std::vector<safe_real>>& X,
+    field_view<const safe_real> U, const std::vector<std::vector<safe_real>>& X,
     const double omega, const size_t device_id,
-    std::vector<hydro_state_t<std::vector<safe_real>>>& F) {
+    std::vector<field_storage<safe_real>>& F) {
 
     // Init local kernel pool if not done already
     hpx::lcos::local::call_once(init_hydro_pool_flag, init_hydro_aggregation_pool);
@@ -185,9 +185,7 @@ timestep_t launch_hydro_cuda_kernels(const hydro_computer<NDIM, INX, physics<NDI
       hpx::util::annotated_function([&]() {
         // Convert input
         convert_x_structure(X, combined_x.data() + x_slice_offset * slice_id);
-        for (int f = 0; f < hydro.get_nf(); f++) {
-            std::copy(U[f].begin(), U[f].end(), combined_u.data() + f * H_N3 + u_slice_offset * slice_id);
-        }
+        copy_fields(U, hydro.get_nf(), combined_u.data() + u_slice_offset * slice_id, H_N3);
       }, "cuda_hydro_solver::convert_input")();
 
       const auto& disc_detect_bool = hydro.get_disc_detect();
@@ -6,6 +6,7 @@
 
 #include "octotiger/unitiger/hydro_impl/hydro_kernel_interface.hpp"
 #include "octotiger/unitiger/hydro_impl/flux_kernel_interface.hpp"
+#include "octotiger/kernel_counters.hpp"
 #ifdef OCTOTIGER_HAVE_KOKKOS
 #include <hpx/kokkos/executors.hpp>
 #include <hpx/kokkos.hpp>
@@ -46,8 +47,8 @@ void init_hydro_kokkos_aggregation_pool(void) {
 
 
 timestep_t launch_hydro_kernels(hydro_computer<NDIM, INX, physics<NDIM>>& hydro,
-    const std::vector<std::vector<safe_real>>& U, std::vector<std::vector<safe_real>>& X,
-    const double omega, std::vector<hydro_state_t<std::vector<safe_real>>>& F,
+    field_view<const safe_real> U, std::vector<std::vector<safe_real>>& X,
+    const double omega, std::vector<field_storage<safe_real>>& F,
     const interaction_host_kernel_type host_type, const interaction_device_kernel_type device_type,
     const size_t cuda_buffer_capacity) {
     static const cell_geometry<NDIM, INX> geo;
@@ -129,6 +130,7 @@ timestep_t launch_hydro_kernels(hydro_computer<NDIM, INX, physics<NDIM>>& hydro,
     }
 
     // Nothing is available or device execution is disabled - fallback to host execution
+    kernel_counters::scope kc(kernel_counters::hydro, host_type, kernel_counters::hydro_cost);
     if (host_type == interaction_host_kernel_type::KOKKOS) {
 #ifdef OCTOTIGER_HAVE_KOKKOS
         hpx::lcos::local::call_once(init_hydro_kokkos_pool_flag, init_hydro_kokkos_aggregation_pool);
@@ -148,24 +150,27 @@ timestep_t launch_hydro_kernels(hydro_computer<NDIM, INX, physics<NDIM>>& hydro,
             std::vector<std::vector<safe_real>>(opts().n_fields, std::vector<safe_real>(H_N3)));
         const auto& q = hydro.reconstruct(U, X, omega);
         max_lambda = hydro.flux(U, q, f, X, omega);
-        // Use legacy conversion
+        // Use legacy conversion: both layouts are contiguous in k, so copy whole rows
         for (int dim = 0; dim < NDIM; dim++) {
             for (integer field = 0; field != opts().n_fields; ++field) {
+                const auto& src = f[dim][field];
+                auto dest = F[dim][field];
                 for (integer i = 0; i <= INX; ++i) {
                     for (integer j = 0; j <= INX; ++j) {
-                        for (integer k = 0; k <= INX; ++k) {
-                            const auto i0 = findex(i, j, k);
-                            F[dim][field][i0] = f[dim][field][hindex(i + H_BW, j + H_BW, k + H_BW)];
-                            real rho_tot = 0.0;
-                            for (integer field = spc_i; field != spc_i + opts().n_species;
-                                 ++field) {
-                                rho_tot += F[dim][field][i0];
-                            }
-                            F[dim][rho_i][i0] = rho_tot;
-                        }
+                        const auto h0 = hindex(i + H_BW, j + H_BW, H_BW);
+                        std::copy(src.begin() + h0, src.begin() + h0 + INX + 1,
+                            dest.begin() + findex(i, j, 0));
                     }
                 }
             }
+            auto rho_flux = F[dim][rho_i];
+            for (integer i0 = 0; i0 != F_N3; ++i0) {
+                real rho_tot = 0.0;
+                for (integer field = spc_i; field != spc_i + opts().n_species; ++field) {
+                    rho_tot += F[dim][field][i0];
+                }
+                rho_flux[i0] = rho_tot;
+            }
         }
         return max_lambda;
     } else {
@@ -8,11 +8,11 @@
 
 
 
+#include "octotiger/io/io_pool.hpp"
 #include "octotiger/print.hpp"
 #include "octotiger/defs.hpp"
 #include "octotiger/real.hpp"
 
-#include <hpx/include/run_as.hpp>
 #include <hpx/include/threads.hpp>
 
 #include <cmath>
@@ -43,8 +43,8 @@ real LambertW(real z) {
 }
 
 int file_copy(const char* fin, const char* fout) {
-    // run output on separate thread
-    auto f = hpx::threads::run_as_os_thread([&]()
+    // run output on the I/O pool
+    auto f = io::submit([&]()
     {
 	    constexpr size_t chunk_size = BUFSIZ;
 	    char buffer[chunk_size];
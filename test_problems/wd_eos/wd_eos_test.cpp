@@ -0,0 +1,118 @@
+//  Copyright (c) 2019 AUTHORS
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// White dwarf eos test
+//
+// Evaluates wd_eos::state and wd_eos::pressure with the host SIMD type of the hydro kernels and
+// with plain doubles over a density range that covers the x = 0.001 switch and compares the lanes.
+// The scalar results are checked against the std::asinh formula the kernels used before
+// fast_asinh, and fast_asinh itself against std::asinh.
+
+#include "octotiger/common_kernel/kokkos_simd.hpp"
+#include "octotiger/unitiger/hydro_impl/wd_eos_kernel_templates.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// White dwarf constants in cgs units (see grid::get_rho_c)
+constexpr double A = 6.00228e+22;
+constexpr double B = 2 * 9.81011e+5;
+
+// SIMD and scalar evaluations have to agree up to rounding
+constexpr double simd_tolerance = 1.0e-14;
+// Against std::asinh, relative to the largest term of the cancelling sum
+constexpr double reference_tolerance = 1.0e-14;
+constexpr double asinh_tolerance = 1.0e-15;
+
+double relative_error(const double a, const double b) {
+	const double scale = std::max(std::abs(a), std::abs(b));
+	return scale > 0.0 ? std::abs(a - b) / scale : 0.0;
+}
+
+// Degenerate pressure as computed by the kernels before fast_asinh
+double reference_pressure(const double x, double& scale) {
+	const double x_sqr = x * x;
+	const double x_sqr_sqrt = std::sqrt(x_sqr + 1.0);
+	scale = A * (std::abs(x * (2.0 * x_sqr - 3.0) * x_sqr_sqrt) + 3.0 * std::asinh(x));
+	if (x < 0.001) {
+		scale = 1.6 * A * x_sqr * x_sqr * x;
+		return scale;
+	}
+	return A * (x * (2.0 * x_sqr - 3.0) * x_sqr_sqrt + 3.0 * std::asinh(x));
+}
+
+double max_fast_asinh_error(const int samples = 1 << 16) {
+	double max_error = 0.0;
+	for (int i = 0; i <= samples; i++) {
+		const double x = std::exp2(-40.0 + 240.0 * i / samples);
+		const double exact = std::asinh(x);
+		max_error = std::max(max_error, std::abs(wd_eos::fast_asinh(x, std::sqrt(x * x + 1.0)) - exact) / exact);
+	}
+	return max_error;
+}
+
+}
+
+int main() {
+	constexpr int lanes = host_simd_t::size();
+	constexpr int samples = 1 << 14;
+	// x = (rho / B)^(1/3) from 1e-5 to 1e4
+	std::vector<double> rho(samples);
+	for (int i = 0; i < samples; i++) {
+		rho[i] = B * std::pow(10.0, -15.0 + 27.0 * i / (samples - 1));
+	}
+
+	double max_simd_error = 0.0;
+	double max_reference_error = 0.0;
+	for (int i = 0; i < samples; i += lanes) {
+		std::array<double, lanes> rho_lanes;
+		std::array<double, lanes> x_lanes;
+		for (int l = 0; l < lanes; l++) {
+			rho_lanes[l] = rho[std::min(i + l, samples - 1)];
+			x_lanes[l] = std::pow(rho_lanes[l] / B, 1.0 / 3.0);
+		}
+		host_simd_t rho_simd, x_simd;
+		rho_simd.copy_from(rho_lanes.data(), SIMD_NAMESPACE::element_aligned_tag{});
+		x_simd.copy_from(x_lanes.data(), SIMD_NAMESPACE::element_aligned_tag{});
+		host_simd_t pdeg_simd, edeg_simd, dpdeg_drho_simd;
+		wd_eos::state(A, B, rho_simd, pdeg_simd, edeg_simd, dpdeg_drho_simd);
+		const host_simd_t p_simd = wd_eos::pressure(A, x_simd);
+
+		std::array<double, lanes> pdeg_lanes, edeg_lanes, dpdeg_drho_lanes, p_lanes;
+		pdeg_simd.copy_to(pdeg_lanes.data(), SIMD_NAMESPACE::element_aligned_tag{});
+		edeg_simd.copy_to(edeg_lanes.data(), SIMD_NAMESPACE::element_aligned_tag{});
+		dpdeg_drho_simd.copy_to(dpdeg_drho_lanes.data(), SIMD_NAMESPACE::element_aligned_tag{});
+		p_simd.copy_to(p_lanes.data(), SIMD_NAMESPACE::element_aligned_tag{});
+		for (int l = 0; l < lanes; l++) {
+			double pdeg, edeg, dpdeg_drho;
+			wd_eos::state(A, B, rho_lanes[l], pdeg, edeg, dpdeg_drho);
+			const double p = wd_eos::pressure(A, x_lanes[l]);
+			max_simd_error = std::max(max_simd_error, relative_error(pdeg_lanes[l], pdeg));
+			max_simd_error = std::max(max_simd_error, relative_error(edeg_lanes[l], edeg));
+			max_simd_error = std::max(max_simd_error, relative_error(dpdeg_drho_lanes[l], dpdeg_drho));
+			max_simd_error = std::max(max_simd_error, relative_error(p_lanes[l], p));
+			double scale;
+			const double p_reference = reference_pressure(x_lanes[l], scale);
+			max_reference_error = std::max(max_reference_error, std::abs(p - p_reference) / scale);
+		}
+	}
+	const double asinh_error = max_fast_asinh_error();
+
+	printf("wd_eos: %i SIMD lanes, %i densities\n", lanes, samples);
+	printf("wd_eos: SIMD against scalar pressure and edeg, max relative error %e\n", max_simd_error);
+	printf("wd_eos: scalar pressure against std::asinh, max error %e\n", max_reference_error);
+	printf("wd_eos: fast_asinh against std::asinh, max relative error %e\n", asinh_error);
+	if (max_simd_error > simd_tolerance || max_reference_error > reference_tolerance || asinh_error > asinh_tolerance) {
+		printf("ERROR: wd_eos exceeds its tolerances\n");
+		return 1;
+	}
+	printf("wd_eos: PASSED\n");
+	return 0;
+}